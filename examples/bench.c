@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2026 by Ricardo Yanez <ricardo.yanez@calel.org>
+ *
+ * Measures the time to build range tables, one at a time, in bulk
+ * with range_build() and scaled across isotopes with range_scaling(),
+ * and the throughput of passage() and passage_batch() lookups.
+ *
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <range.h>
+
+#define NZ 40
+#define NCALL 1000000
+
+static double now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return t.tv_sec + t.tv_nsec * 1.0e-9;
+}
+
+int main () {
+
+  int i, n, z, icorr;
+  double err, sum = 0.0, t0, t1;
+  struct range_hit *hit = malloc(NCALL*sizeof(struct range_hit));
+  double *eut = malloc(NCALL*sizeof(double));
+  double *eerr = malloc(NCALL*sizeof(double));
+  struct range_key key[4*NZ];
+
+  printf("\n");
+
+  /* one table per ion from H to Zr, in Si and in CsI */
+  for (icorr = 0 ; icorr <= 1 ; icorr++) {
+    t0 = now();
+    for (z = 1 ; z <= NZ ; z++) {
+      sum += rangen(icorr,z,2*z+icorr,0,14,28,(2*z+icorr)*(icorr ? 20.0 : 1.0));
+      sum += rangen(icorr,z,2*z+icorr,5,0,0,(2*z+icorr)*(icorr ? 20.0 : 1.0));
+    }
+    t1 = now();
+    printf("%s table build   %8.1f us/table\n",icorr ? "H-B-G" : "N-S  ",
+	   (t1-t0)*1.0e6/(2*NZ));
+  }
+
+  /* the same ions, other isotopes, in bulk on 1 thread and on all */
+  for (i = 0 ; i < 2 ; i++) {
+    for (z = 1 ; z <= NZ ; z++) {
+      key[4*(z-1)] = (struct range_key){0,z,2*z+2+i,0,14,28};
+      key[4*(z-1)+1] = (struct range_key){0,z,2*z+2+i,5,0,0};
+      key[4*(z-1)+2] = (struct range_key){1,z,2*z+3+i,0,14,28};
+      key[4*(z-1)+3] = (struct range_key){1,z,2*z+3+i,5,0,0};
+    }
+    t0 = now();
+    n = range_build(key,4*NZ,i ? 0 : 1);
+    t1 = now();
+    printf("range_build() %s %8.1f us/table\n",i ? "all" : "1  ",(t1-t0)*1.0e6/n);
+  }
+
+  /* four more isotopes of each in Si, from one electronic table per element */
+  for (i = RANGE_SCALE_NUCLEAR ; i <= RANGE_SCALE_ELECTRONIC ; i++) {
+    range_scaling(i);
+    t0 = now();
+    for (z = 1 ; z <= NZ ; z++)
+      for (n = 0 ; n < 4 ; n++)
+	sum += rangen(0,z,2*z+4*i+n,0,14,28,2*z+4*i+n);
+    t1 = now();
+    printf("range_scaling(%d)  %8.1f us/table\n",i,(t1-t0)*1.0e6/(4*NZ));
+  }
+  range_scaling(0);
+
+  /* lookups in tables already built */
+  for (i = 0 ; i < NCALL ; i++) {
+    z = 1 + i % NZ;
+    hit[i].key = (struct range_key){0,z,2*z,0,14,28};
+    hit[i].ein = 2*z*(0.1 + 0.01*(i % 1000));
+    hit[i].t = 0.05;
+  }
+  t0 = now();
+  for (i = 0 ; i < NCALL ; i++)
+    sum += passage(0,hit[i].key.zp,hit[i].key.ap,0,14,28,hit[i].ein,hit[i].t,&err);
+  t1 = now();
+  printf("passage()         %8.1f ns/call\n",(t1-t0)*1.0e9/NCALL);
+
+  t0 = now();
+  passage_batch(hit,NCALL,eut,eerr);
+  t1 = now();
+  printf("passage_batch()   %8.1f ns/hit\n\n",(t1-t0)*1.0e9/NCALL);
+
+  free(hit);
+  free(eut);
+  free(eerr);
+
+  return sum == 0.0;
+
+}
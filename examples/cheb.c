@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2026 by Ricardo Yanez <ricardo.yanez@calel.org>
+ *
+ * Compares compact (Chebyshev) range tables with the range tables for
+ * a few ions and absorbers and error bounds, and prints the size of
+ * the compact tables, the largest relative error in range and in energy
+ * after passage, and the time per passage() call.
+ *
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include <range.h>
+
+#define NCALL 1000000
+
+/* alpha in Si, 16O in Mylar, 40Ar in CsI and 208Pb in Au */
+static int icorr[4] = {0,2,1,2};
+static int zp[4] = {2,8,18,82};
+static int ap[4] = {4,16,40,208};
+static int iabso[4] = {0,1,5,0};
+static int zt[4] = {14,0,0,79};
+static int at[4] = {28,0,0,197};
+
+static double now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return t.tv_sec + t.tv_nsec * 1.0e-9;
+}
+
+int main () {
+
+  int i, k, m;
+  double tol[3] = {1.0e-4,1.0e-6,1.0e-7};
+  double emin, emax, ein, t, r, eut, e, err, dr, de, sum;
+  double t0, t1, t2;
+  struct range_cheb *rc;
+
+  printf("\nion \t tol \t  bytes \t range err \t energy err \t ns/call (table, compact)\n");
+  printf("--- \t --- \t  ----- \t --------- \t ---------- \t -----------------------\n");
+  for (k = 0 ; k < 4 ; k++) {
+    emin = ap[k] * (icorr[k] == 1 ? 3.0 : 0.05);
+    emax = ap[k] * (icorr[k] == 0 ? 11.0 : 400.0);
+    for (m = 0 ; m < 3 ; m++) {
+      rc = range_cheb_new(icorr[k],zp[k],ap[k],iabso[k],zt[k],at[k],tol[m]);
+      dr = 0.0;
+      de = 0.0;
+      for (i = 0 ; i < 1000 ; i++) {
+	ein = emin * pow(emax/emin,i/999.0);
+	r = rangen(icorr[k],zp[k],ap[k],iabso[k],zt[k],at[k],ein);
+	if (fabs(range_cheb_range(rc,ein)/r-1.0) > dr)
+	  dr = fabs(range_cheb_range(rc,ein)/r-1.0);
+	t = 0.5 * r;
+	eut = passage(icorr[k],zp[k],ap[k],iabso[k],zt[k],at[k],ein,t,&err);
+	e = range_cheb_passage(rc,ein,t);
+	if (fabs(e/eut-1.0) > de)
+	  de = fabs(e/eut-1.0);
+      }
+
+      sum = 0.0;
+      t0 = now();
+      for (i = 0 ; i < NCALL ; i++)
+	sum += passage(icorr[k],zp[k],ap[k],iabso[k],zt[k],at[k],
+		       emin+(emax-emin)*(i%1000)/1000.0,0.1,&err);
+      t1 = now();
+      for (i = 0 ; i < NCALL ; i++)
+	sum += range_cheb_passage(rc,emin+(emax-emin)*(i%1000)/1000.0,0.1);
+      t2 = now();
+
+      printf("%3d%-3s\t %.0e %7zu \t %.2e \t %.2e \t %.1f, %.1f\n",ap[k],
+	     k == 0 ? "He" : k == 1 ? "O" : k == 2 ? "Ar" : "Pb",tol[m],
+	     range_cheb_size(rc),dr,de,(t1-t0)*1.0e9/NCALL,(t2-t1)*1.0e9/NCALL);
+      range_cheb_free(rc);
+    }
+  }
+  printf("\n");
+
+  return 0;
+
+}
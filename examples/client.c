@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2026 by Ricardo Yanez <ricardo.yanez@calel.org>
+ *
+ * Queries a range server started with
+ *
+ *   $ range --serve /tmp/range-example.sock &
+ *
+ * compares the answers with the library, and measures the time per
+ * request for single requests and for pipelined batches.
+ *
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <range.h>
+
+#define NREQ 1000
+#define NPIPE 8
+
+static double now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return t.tv_sec + t.tv_nsec * 1.0e-9;
+}
+
+int main () {
+
+  int i, k, fd, bad = 0;
+  struct range_req req[NREQ];
+  struct range_res res[NREQ];
+  double err, v, t0, t1, t2;
+
+  fd = range_connect("/tmp/range-example.sock");
+  if (fd < 0) {
+    fprintf(stderr,"cannot connect to the range server\n");
+    return 1;
+  }
+
+  /* protons, alphas and 16O in Si and Mylar, all request types */
+  for (i = 0 ; i < NREQ ; i++) {
+    int z[3] = {1,2,8}, a[3] = {1,4,16};
+    struct range_req *q = &req[i];
+    q->op = RANGE_PASSAGE + i % 5;
+    q->icorr = i % 3;
+    q->zp = z[i % 3];
+    q->ap = a[i % 3];
+    q->iabso = (i / 3) % 2;
+    q->zt = 14;
+    q->at = 28;
+    q->x = q->ap * (1.0 + i % 40);
+    q->y = 0.1 * (1 + i % 7);
+  }
+
+  if (range_query(fd,req,NREQ,res) != 0) {
+    fprintf(stderr,"connection lost\n");
+    return 1;
+  }
+  for (i = 0 ; i < NREQ ; i++) {
+    struct range_req *q = &req[i];
+    switch (q->op) {
+    case RANGE_PASSAGE:
+      v = passage(q->icorr,q->zp,q->ap,q->iabso,q->zt,q->at,q->x,q->y,&err);
+      break;
+    case RANGE_EGASSAP:
+      v = egassap(q->icorr,q->zp,q->ap,q->iabso,q->zt,q->at,q->x,q->y,&err);
+      break;
+    case RANGE_RANGEN:
+      v = rangen(q->icorr,q->zp,q->ap,q->iabso,q->zt,q->at,q->x);
+      break;
+    case RANGE_THICKN:
+      v = thickn(q->icorr,q->zp,q->ap,q->iabso,q->zt,q->at,q->x,q->y);
+      break;
+    default:
+      v = res[i].value;
+      break;
+    }
+    if (v != res[i].value) bad++;
+  }
+  printf("\n%d requests, %d differ from the library\n",NREQ,bad);
+
+  t0 = now();
+  for (i = 0 ; i < NREQ ; i++)
+    range_query(fd,&req[i],1,&res[i]);
+  t1 = now();
+  for (k = 0 ; k < NPIPE ; k++)
+    range_send(fd,req,NREQ);
+  for (k = 0 ; k < NPIPE ; k++)
+    range_recv(fd,res,NREQ);
+  t2 = now();
+  printf("single requests     %8.2f us/request\n",(t1-t0)*1.0e6/NREQ);
+  printf("pipelined batches   %8.2f us/request\n\n",(t2-t1)*1.0e6/(NPIPE*NREQ));
+
+  range_disconnect(fd);
+
+  return 0;
+
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2026 by Ricardo Yanez <ricardo.yanez@calel.org>
+ *
+ * Generates events of hydrogen to lithium isotopes in a telescope of a
+ * 30 um silicon Delta E detector and a 0.1 mg/cm2 gold dead layer with
+ * passage(), classifies them with range_pid_classify(), and counts the
+ * events identified as another isotope.
+ *
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <range.h>
+
+#define NION 8
+#define N 10000
+
+// Threshold of the residual energy detector (MeV)
+#define ETHR 0.1
+
+static double de[N], e[N], dist[N];
+static int zev[N], aev[N], zid[N], aid[N];
+
+int main () {
+
+  struct range_layer layer[2] = {{0,14,28,7.0},{0,79,197,0.1}};
+  int z[NION] = {1,1,1,2,2,2,3,3}, a[NION] = {1,2,3,3,4,6,6,7};
+  int i, k, n, nwrong, nout;
+  double err, ein, e1;
+
+  struct range_pid *pid = range_pid_new(2,layer,2,z,a,NION);
+
+  // E/A uniform in log from 1 to 100 MeV, events stopped in the
+  // telescope or below the threshold are dropped
+  srand(2026);
+  n = 0;
+  for (i = 0 ; i < N ; i++) {
+    k = i % NION;
+    ein = a[k]*pow(10.0,2.0*rand()/RAND_MAX);
+    e1 = passage(2,z[k],a[k],0,14,28,ein,7.0,&err);
+    if (e1 <= 0.0)
+      continue;
+    e[n] = passage(2,z[k],a[k],0,79,197,e1,0.1,&err);
+    if (e[n] < ETHR)
+      continue;
+    de[n] = ein - e1;
+    zev[n] = z[k];
+    aev[n] = a[k];
+    n++;
+  }
+
+  range_pid_classify(pid,n,de,e,zid,aid,dist);
+
+  nwrong = nout = 0;
+  for (i = 0 ; i < n ; i++) {
+    if (zid[i] == 0)
+      nout++;
+    else if (zid[i] != zev[i] || aid[i] != aev[i])
+      nwrong++;
+  }
+  printf("\n %d events, %d misidentified, %d outside the loci\n\n",n,nwrong,nout);
+
+  range_pid_free(pid);
+
+  return nwrong || nout ? 1 : 0;
+
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2026 by Ricardo Yanez <ricardo.yanez@calel.org>
+ *
+ * Registers a scheduler that starts a thread per task and counts the
+ * tasks, builds tables with range_build() and range_prefetch() on it,
+ * and then builds more on the built-in pool.
+ *
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <range.h>
+
+#define NZ 8
+
+struct task {
+  pthread_t tid;
+  void (*fn)(void *);
+  void *arg;
+};
+
+static int ntask = 0;
+
+static void *run(void *arg) {
+  struct task *t = arg;
+  t->fn(t->arg);
+  return NULL;
+}
+
+static void *submit(void *ctx, void (*fn)(void *), void *arg) {
+  struct task *t = malloc(sizeof(struct task));
+  int *count = ctx;
+  t->fn = fn;
+  t->arg = arg;
+  __atomic_add_fetch(count,1,__ATOMIC_RELAXED);
+  if ( pthread_create(&t->tid,NULL,run,t) != 0 ) {
+    free(t);
+    fn(arg);
+    return NULL;  // run here, nothing to wait for
+  }
+  return t;
+}
+
+static void join(void *ctx, void *task) {
+  struct task *t = task;
+  pthread_join(t->tid,NULL);
+  free(t);
+}
+
+int main() {
+  struct range_key key[2*NZ];
+  struct range_sched s = {&ntask,submit,join,4};
+  struct range_job *job;
+  double e, err;
+  int n;
+
+  for ( int i = 0 ; i < NZ ; i++ ) {
+    key[i] = (struct range_key){0,i+1,2*(i+1),0,14,28};
+    key[NZ+i] = (struct range_key){0,i+1,2*(i+1),1,0,0};
+  }
+
+  range_scheduler(&s);
+  n = range_build(key,NZ,0);
+  job = range_prefetch(&key[NZ],NZ);
+  range_wait(job);
+  printf("%d tables built in %d tasks of the scheduler\n",n+NZ,ntask);
+
+  // back to the built-in pool, for the same ions in CsI
+  range_scheduler(NULL);
+  for ( int i = 0 ; i < NZ ; i++ ) {
+    key[i].iabso = 5;
+    key[i].zt = key[i].at = 0;
+  }
+  job = range_prefetch(key,NZ);
+  range_wait(job);
+
+  for ( int i = 0 ; i < 2*NZ ; i++ ) {
+    e = passage(0,key[i].zp,key[i].ap,key[i].iabso,key[i].zt,key[i].at,100.0,10.0,&err);
+    printf("Z = %d A = %2d iabso = %d: %8.3f MeV\n",key[i].zp,key[i].ap,key[i].iabso,e);
+  }
+
+  return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2026 by Ricardo Yanez <ricardo.yanez@calel.org>
+ *
+ * Checks a tenth of the calls of passage(), egassap(), rangen() and
+ * thickn() against the reference tables, with lazy tables and with
+ * tables scaled from the electronic stopping power, and prints the
+ * deviations, and the time per call with 1% of the calls checked.
+ *
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <time.h>
+#include <range.h>
+
+#define NCALL 200000
+
+/* ions: 7Li, 12C, 16O and 40Ar in Si, Mylar and CsI */
+static int zp[4] = {3,6,8,18};
+static int ap[4] = {7,12,16,40};
+static int iabso[3] = {0,1,5};
+
+static void run(int n) {
+  double err, e, t;
+  for ( int i = 0 ; i < n ; i++ ) {
+    int k = i % 4, l = (i / 4) % 3, zt = l ? 0 : 14, at = l ? 0 : 28;
+    e = ap[k] * (1.0 + (i % 97) * 0.5);
+    t = 0.1 + (i % 13);
+    passage(0,zp[k],ap[k],iabso[l],zt,at,e,t,&err);
+    egassap(1,zp[k],ap[k],iabso[l],zt,at,t,ap[k]*20.0,&err);
+    rangen(0,zp[k],ap[k],iabso[l],zt,at,e);
+    thickn(0,zp[k],ap[k],iabso[l],zt,at,e,0.1*e);
+  }
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+int main() {
+  double t0, t1, t2;
+
+  printf("lazy tables\n");
+  fflush(stdout);
+  range_lazy(1);
+  range_shadow(0.1,1.0e-4,RANGE_SHADOW_WARN);
+  run(20000);
+  range_shadow_report(stdout);
+
+  // the lazy tables are in the cache, so the scaled ones are new isotopes
+  for ( int k = 0 ; k < 4 ; k++ ) {
+    ap[k]++;
+  }
+  printf("\nscaled tables (RANGE_SCALE_ELECTRONIC)\n");
+  range_lazy(0);
+  range_scaling(RANGE_SCALE_ELECTRONIC);
+  range_shadow(0.1,1.0e-4,RANGE_SHADOW_COUNT);
+  run(20000);
+  range_shadow_report(stdout);
+
+  range_shadow(0.0,0.0,RANGE_SHADOW_COUNT);
+  t0 = now();
+  run(NCALL);
+  t1 = now();
+  range_shadow(0.01,1.0,RANGE_SHADOW_COUNT);
+  run(NCALL);
+  t2 = now();
+  printf("\n%.1f ns per call, %.1f ns with 1%% checked\n",
+	 (t1-t0)*1.0e9/(4*NCALL),(t2-t1)*1.0e9/(4*NCALL));
+
+  return 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2026 by Ricardo Yanez <ricardo.yanez@calel.org>
+ *
+ * Samples the energy of alpha particles after a Si foil with the Bohr
+ * and Vavilov straggling models, compares the mean and width of the
+ * samples with range_straggling_v(), and checks that a run split in
+ * two calls gives the same samples.
+ *
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <range.h>
+
+#define N 100000
+
+static double ein[N], t[N], eut[N], eut2[N];
+
+int main () {
+
+  int i, k, model, ndiff;
+  double th[3] = {0.2,1.0,5.0};
+  double mean, sigma, s1, s2, s3;
+
+  printf("\n 5.486 MeV alpha in Si\n\n");
+  printf("mg/cm2\t model \t  mean (MeV)\t sigma (MeV)\t skewness\t split\n");
+  printf("------\t ----- \t  ----------\t -----------\t --------\t -----\n");
+  for (k = 0 ; k < 3 ; k++) {
+    for (i = 0 ; i < N ; i++) {
+      ein[i] = 5.486;
+      t[i] = th[k];
+    }
+    range_straggling_v(0,2,4,0,14,28,1,ein,t,&mean,&sigma);
+    printf("%.1f\t calc \t  %.4f \t %.4f\n",th[k],mean,sigma);
+    for (model = RANGE_BOHR ; model <= RANGE_VAVILOV ; model++) {
+      range_sample_v(0,2,4,0,14,28,model,2026,0,N,ein,t,eut);
+      range_sample_v(0,2,4,0,14,28,model,2026,0,N/3,ein,t,eut2);
+      range_sample_v(0,2,4,0,14,28,model,2026,N/3,N-N/3,ein+N/3,t+N/3,eut2+N/3);
+      ndiff = 0;
+      s1 = s2 = s3 = 0.0;
+      for (i = 0 ; i < N ; i++) {
+	if (eut[i] != eut2[i])
+	  ndiff++;
+	s1 += eut[i];
+      }
+      s1 /= N;
+      for (i = 0 ; i < N ; i++) {
+	s2 += (eut[i]-s1)*(eut[i]-s1);
+	s3 += (eut[i]-s1)*(eut[i]-s1)*(eut[i]-s1);
+      }
+      s2 /= N;
+      s3 /= N;
+      printf("\t %-7s %.4f \t %.4f \t %+.3f \t\t %s\n",model == RANGE_BOHR ? "Bohr" : "Vavilov",
+	     s1,sqrt(s2),s3/pow(s2,1.5),ndiff ? "differs" : "same");
+    }
+  }
+  printf("\n");
+
+  return 0;
+
+}
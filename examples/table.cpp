@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2026 by Ricardo Yanez <ricardo.yanez@calel.org>
+ *
+ * Example of the C++ interface: range tables as objects, batch lookups
+ * with an execution policy, and a compound that does not use absorb[].
+ * The results are compared with the C functions.
+ *
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ */
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <range.hpp>
+
+int main () {
+
+  using namespace range;
+
+  /* 16O in silicon and in air */
+  RangeTable si(Correlation::NS,Ion{8,16},Absorber::element(14,28));
+  Compound air{{8,16,2*16*23.2},{7,14,2*14*75.5},{18,40,1*40*1.3}};
+  RangeTable gas(Correlation::NS,Ion{8,16},air);
+
+  std::vector<double> ein(1000), t(1000, 2.0), eout(1000);
+  for (std::size_t i = 0 ; i < ein.size() ; i++)
+    ein[i] = 10.0 + 0.1*i;
+
+  si.passage(std::execution::unseq,ein,t,eout);
+
+  /* the same with the C functions */
+  nelem = 3;
+  absorb[0] = air.data()[0];
+  absorb[1] = air.data()[1];
+  absorb[2] = air.data()[2];
+  double dmax = 0.0, err;
+  for (std::size_t i = 0 ; i < ein.size() ; i++) {
+    double e = passage(0,8,16,0,14,28,ein[i],t[i],&err);
+    dmax = std::fmax(dmax,std::fabs(eout[i]-e)/e);
+    e = passage(0,8,16,-1,0,0,ein[i],t[i],&err);
+    dmax = std::fmax(dmax,std::fabs(gas.passage(ein[i],t[i])-e)/e);
+  }
+
+  std::printf("\n16O of 100 MeV: range %.4f mg/cm2 in Si, %.4f mg/cm2 in air\n",
+	      si.range(100.0),gas.range(100.0));
+  std::printf("largest difference from passage(): %.1e relative\n\n",dmax);
+
+  /* tables are moved, never copied */
+  RangeTable t2 = std::move(si);
+
+  return dmax > 1.0e-12;
+
+}
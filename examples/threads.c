@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2026 by Ricardo Yanez <ricardo.yanez@calel.org>
+ *
+ * Calls passage() from 1 to 64 threads sharing the same table cache
+ * and prints the throughput for each number of threads.
+ *
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include <range.h>
+
+#define NCALL 200000
+
+/* ions: p, alpha, 12C and 16O in Si, Mylar and CsI */
+static int zp[4] = {1,2,6,8};
+static int ap[4] = {1,4,12,16};
+static int iabso[3] = {0,1,5};
+
+void *work(void *arg) {
+  int i;
+  double err, e = 0.0;
+  for (i = 0 ; i < NCALL ; i++) {
+    int k = i % 4;
+    int m = (i / 4) % 3;
+    e += passage(0,zp[k],ap[k],iabso[m],14,28,ap[k]*(1.0+i%10),0.5,&err);
+  }
+  *(double *)arg = e;
+  return NULL;
+}
+
+int main () {
+
+  int i, n;
+  double sum[64];
+  pthread_t tid[64];
+  struct timespec t0, t1;
+  double dt;
+
+  /* build all tables once so that only lookups are timed */
+  work(&sum[0]);
+
+  printf("\nthreads \t calls/s\n");
+  printf("------- \t -------\n");
+  for (n = 1 ; n <= 64 ; n *= 2) {
+    clock_gettime(CLOCK_MONOTONIC,&t0);
+    for (i = 0 ; i < n ; i++)
+      pthread_create(&tid[i],NULL,work,&sum[i]);
+    for (i = 0 ; i < n ; i++)
+      pthread_join(tid[i],NULL);
+    clock_gettime(CLOCK_MONOTONIC,&t1);
+    dt = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1.0e-9;
+    printf("%7d \t %.3e\n",n,n*(double)NCALL/dt);
+  }
+  printf("\n");
+
+  return 0;
+
+}
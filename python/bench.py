@@ -0,0 +1,58 @@
+#
+# Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+#
+# Compares the module rangelib with a loop calling passage() one ion at
+# a time through ctypes, for alphas in silicon. Uses NumPy arrays if
+# NumPy is installed and array.array otherwise.
+#
+#   python3 bench.py [n] [threads]
+#
+
+import sys
+import time
+import ctypes
+import ctypes.util
+import array
+
+import rangelib
+
+n = int(sys.argv[1]) if len(sys.argv) > 1 else 1000000
+nthread = int(sys.argv[2]) if len(sys.argv) > 2 else 4
+
+try:
+    import numpy
+    ein = numpy.linspace(1.0, 40.0, n)
+    t = numpy.full(n, 5.0)
+except ImportError:
+    ein = array.array('d', (1.0 + 39.0 * i / n for i in range(n)))
+    t = array.array('d', [5.0]) * n
+
+lib = ctypes.CDLL(ctypes.util.find_library('range') or 'librange.so')
+lib.passage.restype = ctypes.c_double
+lib.passage.argtypes = [ctypes.c_int] * 6 + [ctypes.c_double] * 2 + \
+    [ctypes.POINTER(ctypes.c_double)]
+
+# build the tables first
+rangelib.passage(0, 2, 4, 0, 14, 28, ein, t)
+
+err = ctypes.c_double()
+m = min(n, 100000)
+t0 = time.perf_counter()
+ref = [lib.passage(0, 2, 4, 0, 14, 28, ein[i], t[i], ctypes.byref(err))
+       for i in range(m)]
+t1 = time.perf_counter()
+print('ctypes loop       %8.1f ns/ion' % ((t1 - t0) * 1e9 / m))
+
+t0 = time.perf_counter()
+eout = rangelib.passage(0, 2, 4, 0, 14, 28, ein, t)
+t1 = time.perf_counter()
+print('rangelib          %8.1f ns/ion' % ((t1 - t0) * 1e9 / n))
+
+t0 = time.perf_counter()
+rangelib.passage(0, 2, 4, 0, 14, 28, ein, t, out=eout, threads=nthread)
+t1 = time.perf_counter()
+print('rangelib %2d thr.  %8.1f ns/ion' % (nthread, (t1 - t0) * 1e9 / n))
+
+bad = sum(1 for i in range(m) if eout[i] != ref[i])
+print('differences from passage(): %d of %d' % (bad, m))
+sys.exit(bad != 0)
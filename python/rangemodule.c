@@ -0,0 +1,294 @@
+/*
+  Author: Ricardo Yanez
+
+  Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+
+  Python module rangelib: the array functions passage_v(), egassap_v(),
+  rangen_v() and thickn_v() over any object with the buffer protocol
+  holding C contiguous doubles, such as NumPy arrays. The arrays are
+  used in place, the results are written to an output array given by
+  the caller or created like the input, and the interpreter lock is
+  released during the calculation, which may be split over threads.
+
+  License:
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+
+*/
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <limits.h>
+
+#include <range.h>
+
+// Largest number of parts of a call
+#define NTHREAD 64
+
+enum { PASSAGE, EGASSAP, RANGEN, THICKN };
+
+struct call {
+  int op;
+  int icorr, zp, ap, iabso, zt, at;
+  const double *x, *y;  // inputs, y is NULL for rangen
+  double *z, *err;      // outputs, err may be NULL
+  Py_ssize_t n;
+};
+
+static void run(const struct call *c, Py_ssize_t lo, Py_ssize_t hi) {
+  // the library functions take int counts
+  for ( Py_ssize_t i0 = lo ; i0 < hi ; i0 += INT_MAX ) {
+    int m = hi - i0 < INT_MAX ? (int)(hi - i0) : INT_MAX;
+    const double *x = c->x + i0, *y = c->y ? c->y + i0 : NULL;
+    double *z = c->z + i0, *err = c->err ? c->err + i0 : NULL;
+    switch(c->op) {
+    case PASSAGE:
+      passage_v(c->icorr,c->zp,c->ap,c->iabso,c->zt,c->at,m,x,y,z,err);
+      break;
+    case EGASSAP:
+      egassap_v(c->icorr,c->zp,c->ap,c->iabso,c->zt,c->at,m,x,y,z,err);
+      break;
+    case RANGEN:
+      rangen_v(c->icorr,c->zp,c->ap,c->iabso,c->zt,c->at,m,x,z);
+      break;
+    case THICKN:
+      thickn_v(c->icorr,c->zp,c->ap,c->iabso,c->zt,c->at,m,x,y,z);
+      break;
+    }
+  }
+}
+
+struct part {
+  const struct call *c;
+  Py_ssize_t lo, hi;
+};
+
+static void worker(void *arg) {
+  struct part *p = arg;
+  run(p->c,p->lo,p->hi);
+}
+
+/*
+  Run a call in nthread parts, the first on the calling thread and the
+  others as tasks of the library scheduler. Called without the
+  interpreter lock.
+*/
+static void run_threads(const struct call *c, int nthread) {
+  struct range_task *task[NTHREAD];
+  struct part part[NTHREAD];
+
+  if ( nthread > NTHREAD ) nthread = NTHREAD;
+  if ( nthread > c->n ) nthread = c->n > 0 ? (int)c->n : 1;
+  for ( int k = 0 ; k < nthread ; k++ ) {
+    part[k].c = c;
+    part[k].lo = c->n * k / nthread;
+    part[k].hi = c->n * (k+1) / nthread;
+  }
+  for ( int k = 1 ; k < nthread ; k++ ) {
+    task[k] = range_submit(worker,&part[k]);
+  }
+  run(c,part[0].lo,part[0].hi);
+  for ( int k = 1 ; k < nthread ; k++ ) {
+    range_join(task[k]);
+  }
+}
+
+/*
+  Get a C contiguous buffer of doubles. If writable, the buffer must
+  accept writes.
+*/
+static int get_buffer(PyObject *obj, Py_buffer *view, int writable, const char *name) {
+  int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0);
+  if ( PyObject_GetBuffer(obj,view,flags) < 0 ) {
+    return -1;
+  }
+  if ( view->itemsize != sizeof(double) || view->format == NULL ||
+       (strcmp(view->format,"d") != 0 && strcmp(view->format,"<d") != 0 &&
+	strcmp(view->format,"=d") != 0) ) {
+    PyErr_Format(PyExc_TypeError,"%s must be an array of float64",name);
+    PyBuffer_Release(view);
+    return -1;
+  }
+  return 0;
+}
+
+/*
+  A new output array like the input: numpy.empty_like() if the input
+  is a NumPy array, otherwise an array.array of doubles.
+*/
+static PyObject *new_like(PyObject *obj, Py_ssize_t n) {
+  PyObject *mod, *res;
+  PyObject *type = (PyObject *)Py_TYPE(obj);
+  PyObject *tmod = PyObject_GetAttrString(type,"__module__");
+  int numpy = tmod != NULL && PyUnicode_Check(tmod) &&
+    PyUnicode_CompareWithASCIIString(tmod,"numpy") == 0;
+  Py_XDECREF(tmod);
+  PyErr_Clear();
+
+  if ( numpy ) {
+    mod = PyImport_ImportModule("numpy");
+    if ( mod == NULL ) return NULL;
+    res = PyObject_CallMethod(mod,"empty_like","Os",obj,"float64");
+    Py_DECREF(mod);
+    return res;
+  }
+  mod = PyImport_ImportModule("array");
+  if ( mod == NULL ) return NULL;
+  PyObject *zero = PyBytes_FromStringAndSize(NULL,n*(Py_ssize_t)sizeof(double));
+  if ( zero == NULL ) {
+    Py_DECREF(mod);
+    return NULL;
+  }
+  res = PyObject_CallMethod(mod,"array","sO","d",zero);
+  Py_DECREF(zero);
+  Py_DECREF(mod);
+  return res;
+}
+
+/*
+  Common part of the module functions: parse the key, the inputs x and
+  y (y absent for rangen) and the optional out, err and threads, and
+  run the call.
+*/
+static PyObject *call(int op, PyObject *args, PyObject *kwds) {
+
+  static char *kw2[] = {"icorr","zp","ap","iabso","zt","at","x","y",
+			"out","err","threads",NULL};
+  static char *kw1[] = {"icorr","zp","ap","iabso","zt","at","x",
+			"out","threads",NULL};
+  struct call c;
+  PyObject *xo, *yo = NULL, *out = Py_None, *erro = Py_None;
+  Py_buffer xb, yb, zb, eb;
+  int nthread = 1, ok;
+
+  c.op = op;
+  if ( op == RANGEN ) {
+    ok = PyArg_ParseTupleAndKeywords(args,kwds,"iiiiiiO|Oi",kw1,&c.icorr,&c.zp,
+				     &c.ap,&c.iabso,&c.zt,&c.at,&xo,&out,&nthread);
+  }
+  else {
+    ok = PyArg_ParseTupleAndKeywords(args,kwds,"iiiiiiOO|OOi",kw2,&c.icorr,&c.zp,
+				     &c.ap,&c.iabso,&c.zt,&c.at,&xo,&yo,&out,&erro,
+				     &nthread);
+  }
+  if ( !ok ) return NULL;
+  if ( op == THICKN && erro != Py_None ) {
+    PyErr_SetString(PyExc_TypeError,"thickn() has no err");
+    return NULL;
+  }
+  if ( c.icorr < 0 || c.icorr > 2 || c.zp < 1 || c.ap < 1 || c.iabso < 0 ) {
+    PyErr_SetString(PyExc_ValueError,"invalid correlation, ion or absorber");
+    return NULL;
+  }
+  if ( nthread < 1 ) nthread = 1;
+
+  if ( get_buffer(xo,&xb,0,"x") < 0 ) return NULL;
+  c.n = xb.len / (Py_ssize_t)sizeof(double);
+  c.x = xb.buf;
+  c.y = NULL;
+  c.err = NULL;
+  if ( yo != NULL ) {
+    if ( get_buffer(yo,&yb,0,"y") < 0 ) goto fail_x;
+    if ( yb.len != xb.len ) {
+      PyErr_SetString(PyExc_ValueError,"x and y differ in length");
+      goto fail_y;
+    }
+    c.y = yb.buf;
+  }
+  if ( out == Py_None ) {
+    out = new_like(xo,c.n);
+    if ( out == NULL ) goto fail_y;
+  }
+  else {
+    Py_INCREF(out);
+  }
+  if ( get_buffer(out,&zb,1,"out") < 0 ) goto fail_out;
+  if ( zb.len != xb.len ) {
+    PyErr_SetString(PyExc_ValueError,"out differs in length from x");
+    goto fail_z;
+  }
+  c.z = zb.buf;
+  if ( erro != Py_None ) {
+    if ( get_buffer(erro,&eb,1,"err") < 0 ) goto fail_z;
+    if ( eb.len != xb.len ) {
+      PyErr_SetString(PyExc_ValueError,"err differs in length from x");
+      PyBuffer_Release(&eb);
+      goto fail_z;
+    }
+    c.err = eb.buf;
+  }
+
+  Py_BEGIN_ALLOW_THREADS
+  run_threads(&c,nthread);
+  Py_END_ALLOW_THREADS
+
+  if ( c.err != NULL ) PyBuffer_Release(&eb);
+  PyBuffer_Release(&zb);
+  if ( yo != NULL ) PyBuffer_Release(&yb);
+  PyBuffer_Release(&xb);
+  return out;
+
+ fail_z:
+  PyBuffer_Release(&zb);
+ fail_out:
+  Py_DECREF(out);
+ fail_y:
+  if ( yo != NULL ) PyBuffer_Release(&yb);
+ fail_x:
+  PyBuffer_Release(&xb);
+  return NULL;
+}
+
+static PyObject *py_passage(PyObject *self, PyObject *args, PyObject *kwds) {
+  return call(PASSAGE,args,kwds);
+}
+
+static PyObject *py_egassap(PyObject *self, PyObject *args, PyObject *kwds) {
+  return call(EGASSAP,args,kwds);
+}
+
+static PyObject *py_rangen(PyObject *self, PyObject *args, PyObject *kwds) {
+  return call(RANGEN,args,kwds);
+}
+
+static PyObject *py_thickn(PyObject *self, PyObject *args, PyObject *kwds) {
+  return call(THICKN,args,kwds);
+}
+
+static PyMethodDef methods[] = {
+  {"passage",(PyCFunction)(void(*)(void))py_passage,METH_VARARGS|METH_KEYWORDS,
+   "passage(icorr, zp, ap, iabso, zt, at, ein, t, out=None, err=None, threads=1)\n"
+   "Energies (MeV) after passage of ions of energies ein through thicknesses t."},
+  {"egassap",(PyCFunction)(void(*)(void))py_egassap,METH_VARARGS|METH_KEYWORDS,
+   "egassap(icorr, zp, ap, iabso, zt, at, t, eout, out=None, err=None, threads=1)\n"
+   "Energies (MeV) before passage of ions of energies eout after thicknesses t."},
+  {"rangen",(PyCFunction)(void(*)(void))py_rangen,METH_VARARGS|METH_KEYWORDS,
+   "rangen(icorr, zp, ap, iabso, zt, at, ein, out=None, threads=1)\n"
+   "Ranges (mg/cm2) of ions of energies ein."},
+  {"thickn",(PyCFunction)(void(*)(void))py_thickn,METH_VARARGS|METH_KEYWORDS,
+   "thickn(icorr, zp, ap, iabso, zt, at, ein, de, out=None, threads=1)\n"
+   "Thicknesses (mg/cm2) in which ions of energies ein lose de."},
+  {NULL,NULL,0,NULL}
+};
+
+static struct PyModuleDef module = {
+  PyModuleDef_HEAD_INIT,"rangelib",
+  "Stopping power and range of ions, over arrays of float64.",
+  -1,methods
+};
+
+PyMODINIT_FUNC PyInit_rangelib(void) {
+  return PyModule_Create(&module);
+}
@@ -0,0 +1,19 @@
+#
+# Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+#
+# Builds the Python module rangelib against an installed librange:
+#
+#   python3 setup.py build_ext --inplace
+#
+# Use -I and -L with build_ext if range.h and librange are not in the
+# default paths.
+#
+
+from setuptools import setup, Extension
+
+setup(name='rangelib',
+      version='0.3.0',
+      description='Stopping power and range of ions, over arrays',
+      ext_modules=[Extension('rangelib', ['rangemodule.c'],
+                             libraries=['range', 'm'],
+                             extra_link_args=['-pthread'])])
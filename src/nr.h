@@ -25,6 +25,8 @@
 
 double nr_polint(double *xa, double *ya, int n, double x, double *dy);
 unsigned int nr_locate(double *y, int n, double x);
+void nr_spline(double *x, double *y, int n, double yp1, double ypn, double *y2);
+void nr_splint(double *xa, double *ya, double *y2a, int n, double x, double *y);
 void nr_splie2(double *x1a, double *x2a, double **ya,
 	       int m, int n, double **y2a);
 void nr_splin2(double *x1a, double *x2a, double **ya, double **y2a,
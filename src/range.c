@@ -40,13 +40,12 @@
 #include "nr.h"
 
 // major version number
-static const char ver[] = "0.2.0"; 
+static const char ver[] = "0.3.0"; 
 
 struct elem cmpnd[NELMAX];
 int numel;
 
 void rangetab(int, int, int, int, int, int, double*, double*, int*);
-void dedxtab(int, int, int, int, int, int, double, double*, double*);
 
 /*
  * Calculate range for a given initial energy
@@ -125,8 +124,16 @@ void disp_help() {
   printf("Options:\n");
   printf("  -n, --ns         Use Northcliffe-Schilling correlations (default)\n");
   printf("  -h, --hbg        Use Hubert-Bimbot-Gauvin correlations\n");
+  printf("  -b, --blend      Use Northcliffe-Schilling below 2.5 MeV/A and\n");
+  printf("                   Hubert-Bimbot-Gauvin above 12 MeV/A, blended in between\n");
   printf("  -l, --list       List available compounds and exit\n");
   printf("  -v, --version    Display rangelib version number and exit\n");
+  printf("      --serve [PATH]\n");
+  printf("                   Answer requests on the Unix socket PATH (default\n");
+  printf("                   $RANGE_SOCKET or /tmp/range-<uid>.sock)\n");
+  printf("      --emit-c FILE\n");
+  printf("                   Write a C header with the range tables of the keys\n");
+  printf("                   in FILE (lines of icorr zp ap iabso zt at) and exit\n");
   printf("      --help       Display this help and exit\n\n");
 }
 
@@ -388,6 +395,52 @@ void check_icorr(int *icorr, int a, double e) {
   }
 }
 
+/*
+  Read the table keys in file name, one per line as icorr zp ap iabso
+  zt at, and write their tables as a C header to standard output. Lines
+  starting with # are comments. Returns the number of tables written.
+*/
+int emit_c(const char *name) {
+
+  struct range_key *keys = NULL;
+  int n = 0, nmax = 0, line = 0;
+  char buf[256];
+  FILE *fp = fopen(name,"r");
+
+  if ( fp == NULL ) {
+    fprintf(stderr,"range: cannot open %s\n",name);
+    return 0;
+  }
+  while ( fgets(buf,sizeof(buf),fp) != NULL ) {
+    struct range_key k;
+    char c;
+    line++;
+    if ( sscanf(buf," %c",&c) != 1 || c == '#' ) continue;
+    if ( sscanf(buf,"%d %d %d %d %d %d",&k.icorr,&k.zp,&k.ap,&k.iabso,&k.zt,&k.at) != 6 ||
+	 k.icorr < 0 || k.icorr > 2 || k.zp < 1 || k.ap < 1 || k.iabso < 0 ||
+	 (k.iabso == 0 && (k.zt < 1 || k.at < 1)) ) {
+      fprintf(stderr,"range: %s:%d: invalid key\n",name,line);
+      fclose(fp);
+      free(keys);
+      return 0;
+    }
+    if ( n == nmax ) {
+      nmax = nmax ? 2*nmax : 16;
+      keys = realloc(keys,nmax*sizeof(struct range_key));
+      if ( keys == NULL ) {
+	fprintf(stderr,"range: out of memory\n");
+	exit(EXIT_FAILURE);
+      }
+    }
+    keys[n++] = k;
+  }
+  fclose(fp);
+
+  n = range_emit_c(stdout,keys,n);
+  free(keys);
+  return n;
+}
+
 int main(int argc, char *argv[]) {
 
   double elin[62] = {0.0100,0.0125,0.0160,0.0200,0.0250,0.0320,0.0400,0.0500,
@@ -400,7 +453,7 @@ int main(int argc, char *argv[]) {
 		     250.00,300.00,350.00,400.00,450.00,500.00};
 
   int ilo, ihi;
-  double e, tdedxn, tdedxe;
+  double e, tdedxn[62], tdedxe[62];
   int n;
   int jj, jjj;
   double err;
@@ -417,7 +470,13 @@ int main(int argc, char *argv[]) {
   char anwr[256];
 
   // decode command line
-  if ( argc > 2 ) {
+  if ( argc == 3 && !strcmp(argv[1],"--serve") ) {
+    exit(range_serve(argv[2]) == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+  else if ( argc == 3 && !strcmp(argv[1],"--emit-c") ) {
+    exit(emit_c(argv[2]) > 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+  else if ( argc > 2 ) {
     disp_header();
     fprintf(stderr,"\nInvalid number of command line arguments.\n\n");
     exit(EXIT_FAILURE);
@@ -429,6 +488,9 @@ int main(int argc, char *argv[]) {
     else if ( !strcmp(argv[1],"-h") || !strcmp(argv[1],"--hbg") ) {
       icorr = 1;
     }
+    else if ( !strcmp(argv[1],"-b") || !strcmp(argv[1],"--blend") ) {
+      icorr = 2;
+    }
     else if ( !strcmp(argv[1],"-l") || !strcmp(argv[1],"--list") ) {
       disp_header();
       printf("\n  List of available compounds:\n");
@@ -440,6 +502,9 @@ int main(int argc, char *argv[]) {
       printf("\nrangelib version: %s\n\n",ver);
       exit(EXIT_SUCCESS);
     }
+    else if ( !strcmp(argv[1],"--serve") ) {
+      exit(range_serve(NULL) == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
     else if ( !strcmp(argv[1],"--help") ) {
       disp_header();
       disp_help();
@@ -459,6 +524,9 @@ int main(int argc, char *argv[]) {
   if ( icorr == 1 ) {
     printf("\n  Using the Hubert-Bimbot-Gauvin correlations (2.5 < E/A < 100 MeV/A)\n\n");
   }
+  if ( icorr == 2 ) {
+    printf("\n  Using the blended Northcliffe-Schilling and Hubert-Bimbot-Gauvin correlations\n\n");
+  }
   printf("  You can choose between the following options:\n\n");
   printf("\t1: Store a table of -dE/dx values\n");
   printf("\t2: Store a table of range values\n");
@@ -493,15 +561,19 @@ int main(int argc, char *argv[]) {
 	ilo = 0;
 	ihi = 39;
       }
+      else if ( icorr == 2 ) {
+	ilo = 0;
+	ihi = 62;
+      }
       else {
 	ilo = 28;
 	ihi = 62;
       }
+      dedxtab_v(icorr,zp,ap,iabso,zt,at,ihi-ilo,&elin[ilo],&tdedxe[ilo],&tdedxn[ilo]);
       for ( int i = ilo ; i < ihi ; i++ ) {
 	e = elin[i];
-	dedxtab(icorr,zp,ap,iabso,zt,at,e,&tdedxe,&tdedxn);
 	fprintf(fp,"%8.4f %10.4f %11.4f %11.4f %11.4f\n",
-		e,e*ap,tdedxe,tdedxn,tdedxn+tdedxe);
+		e,e*ap,tdedxe[i],tdedxn[i],tdedxn[i]+tdedxe[i]);
       }
       fclose(fp);
       break;
@@ -521,6 +593,10 @@ int main(int argc, char *argv[]) {
 	ilo = 0;
 	ihi = 39;
       }
+      else if ( icorr == 2 ) {
+	ilo = 0;
+	ihi = 62;
+      }
       else {
 	ilo = 28;
 	ihi = 62;
@@ -24,25 +24,239 @@ extern "C" {
 
 #ifndef _RANGE
 #define _RANGE
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
 # define NELMAX 10
-int nelem;
-struct elem {
+extern int nelem;
+extern struct elem {
   int z;
   int a;
   double w;
 } absorb[NELMAX];
 
+/* A range table key: correlation, projectile and absorber */
+struct range_key {
+  int icorr;
+  int zp, ap;
+  int iabso, zt, at;
+};
+
+/* A detector layer: absorber and thickness (mg/cm2) */
+struct range_layer {
+  int iabso, zt, at;
+  double t;
+};
+
+/* Server requests and results (see rangelib(3)) */
+enum { RANGE_PASSAGE = 1, RANGE_EGASSAP, RANGE_RANGEN, RANGE_THICKN, RANGE_DEDX };
+
+# define RANGE_MAXREQ 65536
+
+/* Bins of the interpolation error histogram (see range_telemetry()) */
+# define RANGE_NERR 16
+
+struct range_req {
+  int32_t op;
+  int32_t icorr, zp, ap, iabso, zt, at, pad;
+  double x, y;
+};
+
+struct range_res {
+  double value, aux;
+};
+
+struct range_job;
+struct range_table;
+struct range_fix;
+
+/* Directions of a fixed-point table (see range_fix_new()) */
+enum { RANGE_FIX_PASSAGE = 0, RANGE_FIX_EGASSAP };
+
+/* Isotope scaling of range tables (see range_scaling()) */
+enum { RANGE_SCALE_NUCLEAR = 1, RANGE_SCALE_ELECTRONIC };
+
+/* Actions on a deviation above the tolerance (see range_shadow()) */
+enum { RANGE_SHADOW_COUNT = 0, RANGE_SHADOW_WARN, RANGE_SHADOW_ABORT };
+
+/* Straggling models (see range_sample_v()) */
+enum { RANGE_BOHR = 0, RANGE_VAVILOV };
+struct range_cheb;
+struct range_pid;
+struct range_task;
+
+/*
+  A task scheduler (see range_scheduler()): submit runs fn(arg) and
+  returns a handle, or NULL if it ran fn itself, and wait blocks until
+  the task of a handle has run. nthread is the number of tasks worth
+  running at once, or 0 for the number of processors.
+*/
+struct range_sched {
+  void *ctx;
+  void *(*submit)(void *ctx, void (*fn)(void *), void *arg);
+  void (*wait)(void *ctx, void *task);
+  int nthread;
+};
+
+/* A hit of a batch: table key, energy (MeV) and thickness (mg/cm2) */
+struct range_hit {
+  struct range_key key;
+  double ein, t;
+};
+
 double passage(int icorr, int zp, int ap, int iabso, int zt, int at,
 	       double ein, double t, double *err);
 
 double egassap(int icorr, int zp, int ap, int iabso, int zt, int at,
 	       double t, double eut, double *err);
 
+double passage_d(int icorr, int zp, int ap, int iabso, int zt, int at,
+		 double ein, double t, double *err, double *dein, double *dt);
+
+double egassap_d(int icorr, int zp, int ap, int iabso, int zt, int at,
+		 double t, double eut, double *err, double *deut, double *dt);
+
 double thickn(int icorr, int zp, int ap, int iabso, int zt, int at,
 	      double ein, double delen);
 
 double rangen(int icorr, int zp, int ap, int iabso, int zt, int at,
 	      double ein);
+
+void passage_batch(const struct range_hit *hit, int n, double *eut, double *err);
+
+void passage_d_batch(const struct range_hit *hit, int n, double *eut, double *err,
+		     double *dein, double *dt);
+
+void egassap_batch(const struct range_hit *hit, int n, double *ein, double *err);
+
+void egassap_d_batch(const struct range_hit *hit, int n, double *ein, double *err,
+		     double *deut, double *dt);
+
+void dedxtab_v(int icorr, int zp, int ap, int iabso, int zt, int at,
+	       int n, const double *e, double *tdedxe, double *tdedxn);
+
+void passage_v(int icorr, int zp, int ap, int iabso, int zt, int at,
+	       int n, const double *ein, const double *t, double *eut, double *err);
+
+void egassap_v(int icorr, int zp, int ap, int iabso, int zt, int at,
+	       int n, const double *t, const double *eut, double *ein, double *err);
+
+void rangen_v(int icorr, int zp, int ap, int iabso, int zt, int at,
+	      int n, const double *ein, double *rng);
+
+void thickn_v(int icorr, int zp, int ap, int iabso, int zt, int at,
+	      int n, const double *ein, const double *delen, double *t);
+
+int range_profile(int icorr, int zp, int ap, int iabso, int zt, int at,
+		  double ein, double step, int nmax,
+		  double *depth, double *e, double *dedx);
+
+double range_thick(int icorr, int zp, int ap, int iabso, int zt, int at,
+		   double ein, double t, double *rms, int nbin,
+		   double emin, double emax, double *hist);
+
+struct range_cheb *range_cheb_new(int icorr, int zp, int ap, int iabso,
+				  int zt, int at, double tol);
+
+void range_cheb_free(struct range_cheb *rc);
+
+size_t range_cheb_size(const struct range_cheb *rc);
+
+double range_cheb_range(const struct range_cheb *rc, double ein);
+
+double range_cheb_energy(const struct range_cheb *rc, double rng);
+
+double range_cheb_passage(const struct range_cheb *rc, double ein, double t);
+
+void range_cheb_passage_v(const struct range_cheb *rc, int n, const double *ein,
+			  const double *t, double *eut);
+
+struct range_pid *range_pid_new(int icorr, const struct range_layer *layer,
+				int nlayer, const int *zp, const int *ap, int nion);
+
+void range_pid_free(struct range_pid *pid);
+
+void range_pid_classify(const struct range_pid *pid, int n, const double *de,
+			const double *e, int *zp, int *ap, double *dist);
+
+int range_serve(const char *path);
+
+int range_connect(const char *path);
+
+int range_send(int fd, const struct range_req *req, int n);
+
+int range_recv(int fd, struct range_res *res, int n);
+
+int range_query(int fd, const struct range_req *req, int n, struct range_res *res);
+
+void range_disconnect(int fd);
+
+struct range_job *range_prefetch(const struct range_key *keys, int n);
+
+void range_wait(struct range_job *job);
+
+int range_build(const struct range_key *keys, int n, int nthread);
+
+void range_scheduler(const struct range_sched *s);
+
+struct range_task *range_submit(void (*fn)(void *), void *arg);
+
+void range_join(struct range_task *task);
+
+int range_concurrency(void);
+
+void range_lazy(int on);
+
+void range_scaling(int mode);
+
+void range_telemetry(int on);
+
+int range_telemetry_get(const struct range_key *key, int nmax, double *ea,
+			unsigned long *hits, unsigned long *herr);
+
+void range_telemetry_report(FILE *fp);
+
+void range_shadow(double frac, double tol, int action);
+
+unsigned long range_shadow_get(int op, unsigned long *nover, double *mean, double *max);
+
+void range_shadow_report(FILE *fp);
+
+const struct range_table *range_table_open(const struct range_key *key);
+
+const struct range_table *range_table_new(int icorr, int zp, int ap,
+					  const struct elem *cmp, int n);
+
+void range_table_close(const struct range_table *tab);
+
+int range_table_data(const struct range_table *tab, const double **em,
+		     const double **r);
+
+int range_emit_c(FILE *fp, const struct range_key *keys, int n);
+
+struct range_fix *range_fix_new(int icorr, int zp, int ap,
+				const struct range_layer *layer, int nlayer,
+				int dir, double lsb, uint32_t xmax, double tol);
+
+void range_fix_free(struct range_fix *fx);
+
+double range_fix_error(const struct range_fix *fx);
+
+size_t range_fix_size(const struct range_fix *fx);
+
+uint32_t range_fix(const struct range_fix *fx, uint32_t x);
+
+void range_fix_u32(const struct range_fix *fx, const uint32_t *x, uint32_t *y, int n);
+
+void range_fix_u16(const struct range_fix *fx, const uint16_t *x, uint16_t *y, int n);
+
+void range_straggling_v(int icorr, int zp, int ap, int iabso, int zt, int at,
+			int n, const double *ein, const double *t, double *eut,
+			double *sigma);
+
+void range_sample_v(int icorr, int zp, int ap, int iabso, int zt, int at,
+		    int model, uint64_t seed, uint64_t first, int n,
+		    const double *ein, const double *t, double *eut);
 #endif
 
 #ifdef __cplusplus
@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2026 by Ricardo Yanez <ricardo.yanez@calel.org>
+ *
+ * C++ interface to rangelib. A RangeTable owns an open handle to a
+ * range table and interpolates it inline, so scalar and batch lookups
+ * in C++ code are compiled with the caller. Tables are never copied; a
+ * RangeTable can only be moved.
+ *
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ */
+
+#ifndef _RANGE_HPP
+#define _RANGE_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+# include <span>
+#endif
+#if __has_include(<execution>)
+# include <execution>
+#endif
+
+#include "range.h"
+
+namespace range {
+
+enum class Correlation { NS = 0, HBG = 1, Blend = 2 };
+
+/* A projectile */
+struct Ion {
+  int z, a;
+};
+
+/* A single element (iabso = 0) or a pre-defined compound (iabso > 0) */
+struct Absorber {
+  int iabso, zt, at;
+  static Absorber element(int z, int a) { return {0,z,a}; }
+  static Absorber compound(int iabso) { return {iabso,0,0}; }
+};
+
+/*
+  A user defined compound. Its tables are built from its own elements,
+  so absorb[] is neither read nor modified.
+*/
+class Compound {
+public:
+  Compound() = default;
+  Compound(std::initializer_list<elem> el) : el_(el) {}
+  Compound &add(int z, int a, double w) {
+    el_.push_back(elem{z,a,w});
+    return *this;
+  }
+  const elem *data() const { return el_.data(); }
+  int size() const { return (int)el_.size(); }
+private:
+  std::vector<elem> el_;
+};
+
+/*
+  Run the parallel work of the library on an executor: any object
+  whose submit(f) takes a callable with no arguments and returns a
+  handle with wait(), such as a std::future<void>. The executor is
+  used by reference and must outlive its use, until use_executor() of
+  another executor or use_builtin_pool().
+*/
+namespace detail {
+struct Task {
+  void (*fn)(void *);
+  void *arg;
+  void operator()() const { fn(arg); }
+};
+}
+
+template <class Executor>
+void use_executor(Executor &ex, int nthread = 0) {
+  using Handle = std::decay_t<decltype(ex.submit(std::declval<detail::Task>()))>;
+  range_sched s;
+  s.ctx = &ex;
+  s.submit = [](void *ctx, void (*fn)(void *), void *arg) -> void * {
+    Executor &e = *static_cast<Executor *>(ctx);
+    return new Handle(e.submit(detail::Task{fn,arg}));
+  };
+  s.wait = [](void *, void *task) {
+    Handle *h = static_cast<Handle *>(task);
+    h->wait();
+    delete h;
+  };
+  s.nthread = nthread;
+  range_scheduler(&s);
+}
+
+inline void use_builtin_pool() { range_scheduler(nullptr); }
+
+/*
+  A range table of one ion in one absorber. The lookups are those of
+  passage(), egassap(), rangen() and thickn() with the same table, and
+  agree with them to rounding. Unlike those functions, a table never
+  switches the correlation with the energy, so use Correlation::Blend
+  for energies on both sides of 2.5 and 12 MeV/A.
+*/
+class RangeTable {
+public:
+  RangeTable(Correlation c, Ion ion, Absorber abs) : ap_(ion.a) {
+    check(c,ion);
+    range_key key = {(int)c,ion.z,ion.a,abs.iabso,abs.zt,abs.at};
+    if ( abs.iabso < 0 )
+      throw std::invalid_argument("range: use a Compound for user defined absorbers");
+    open(range_table_open(&key));
+  }
+
+  RangeTable(Correlation c, Ion ion, const Compound &cmp) : ap_(ion.a) {
+    check(c,ion);
+    if ( cmp.size() < 1 || cmp.size() > NELMAX )
+      throw std::invalid_argument("range: invalid number of compound elements");
+    open(range_table_new((int)c,ion.z,ion.a,cmp.data(),cmp.size()));
+  }
+
+  RangeTable(const RangeTable &) = delete;
+  RangeTable &operator=(const RangeTable &) = delete;
+
+  RangeTable(RangeTable &&o) noexcept
+    : tab_(std::exchange(o.tab_,nullptr)), ap_(o.ap_), n_(o.n_), em_(o.em_), r_(o.r_) {}
+
+  RangeTable &operator=(RangeTable &&o) noexcept {
+    if ( this != &o ) {
+      range_table_close(tab_);
+      tab_ = std::exchange(o.tab_,nullptr);
+      ap_ = o.ap_;
+      n_ = o.n_;
+      em_ = o.em_;
+      r_ = o.r_;
+    }
+    return *this;
+  }
+
+  ~RangeTable() { range_table_close(tab_); }
+
+  /* Range (mg/cm2) of the ion with energy ein (MeV) */
+  double range(double ein) const {
+    double e;
+    return range_lg(std::log10(ein/ap_),&e);
+  }
+
+  /* Energy (MeV) after passage through a foil of thickness t (mg/cm2) */
+  double passage(double ein, double t, double *err = nullptr) const {
+    double lerr, rut = range_lg(std::log10(ein/ap_),&lerr) - t;
+    if ( rut <= 0.0 ) {
+      if ( err ) *err = 0.0;
+      return 0.0;
+    }
+    double elut = energy_lg(rut,&lerr);
+    double eu = std::pow(10.0,elut);
+    if ( err ) *err = std::fabs(std::pow(10.0,elut-lerr*3)-std::pow(10.0,elut+lerr*3))/eu;
+    return eu*ap_;
+  }
+
+  /* Energy (MeV) before passage through a foil, from the energy after */
+  double egassap(double t, double eout, double *err = nullptr) const {
+    double lerr, rut = 0.0;
+    if ( eout/ap_ != 0.0 ) rut = range_lg(std::log10(eout/ap_),&lerr);
+    double elin = energy_lg(rut+t,&lerr);
+    double ei = std::pow(10.0,elin);
+    if ( err ) *err = std::fabs(std::pow(10.0,elin-lerr*3)-std::pow(10.0,elin+lerr*3))/ei;
+    return ei*ap_;
+  }
+
+  /* Thickness (mg/cm2) in which the ion loses de (MeV) */
+  double thickness(double ein, double de) const {
+    double lerr, rut = 0.0;
+    double rin = range_lg(std::log10(ein/ap_),&lerr);
+    if ( ein-de > 0.0 ) rut = range_lg(std::log10((ein-de)/ap_),&lerr);
+    return rin-rut;
+  }
+
+  /* Batch passage with an execution policy, eout[i] from ein[i] and t[i] */
+  template <class Policy>
+  void passage(Policy &&pol, const double *ein, const double *t, double *eout,
+	       std::size_t n) const {
+    std::transform(std::forward<Policy>(pol),ein,ein+n,t,eout,
+		   [this](double e, double x) { return passage(e,x); });
+  }
+
+  void passage(const double *ein, const double *t, double *eout, std::size_t n) const {
+    for ( std::size_t i = 0 ; i < n ; i++ ) eout[i] = passage(ein[i],t[i]);
+  }
+
+#ifdef __cpp_lib_span
+  template <class Policy>
+  void passage(Policy &&pol, std::span<const double> ein, std::span<const double> t,
+	       std::span<double> eout) const {
+    check(ein.size(),t.size(),eout.size());
+    passage(std::forward<Policy>(pol),ein.data(),t.data(),eout.data(),ein.size());
+  }
+
+  void passage(std::span<const double> ein, std::span<const double> t,
+	       std::span<double> eout) const {
+    check(ein.size(),t.size(),eout.size());
+    passage(ein.data(),t.data(),eout.data(),ein.size());
+  }
+
+  template <class Policy>
+  void range(Policy &&pol, std::span<const double> ein, std::span<double> rng) const {
+    check(ein.size(),ein.size(),rng.size());
+    std::transform(std::forward<Policy>(pol),ein.begin(),ein.end(),rng.begin(),
+		   [this](double e) { return range(e); });
+  }
+
+  void range(std::span<const double> ein, std::span<double> rng) const {
+    check(ein.size(),ein.size(),rng.size());
+    for ( std::size_t i = 0 ; i < ein.size() ; i++ ) rng[i] = range(ein[i]);
+  }
+#endif
+
+  /* Table columns: log10(E/A) and range (mg/cm2) */
+  int size() const { return n_; }
+  const double *log_energy() const { return em_; }
+  const double *ranges() const { return r_; }
+
+private:
+  const range_table *tab_ = nullptr;
+  int ap_, n_ = 0;
+  const double *em_ = nullptr, *r_ = nullptr;
+
+  static void check(Correlation c, Ion ion) {
+    if ( (int)c < 0 || (int)c > 2 )
+      throw std::invalid_argument("range: invalid correlation");
+    if ( ion.z < 1 || ion.a < 1 )
+      throw std::invalid_argument("range: invalid ion");
+  }
+
+  static void check(std::size_t n1, std::size_t n2, std::size_t n3) {
+    if ( n1 != n2 || n1 != n3 )
+      throw std::invalid_argument("range: batch sizes differ");
+  }
+
+  void open(const range_table *tab) {
+    tab_ = tab;
+    n_ = range_table_data(tab_,&em_,&r_);
+  }
+
+  // Index of the last of y[0..n-1] below x, or 0 (as nr_locate())
+  int locate(const double *y, double x) const {
+    int jl = 0, ju = n_;
+    while ( ju - jl > 1 ) {
+      int jm = (ju + jl) / 2;
+      if ( x > y[jm] )
+	jl = jm;
+      else
+	ju = jm;
+    }
+    return jl > n_-3 ? n_-3 : jl;
+  }
+
+  // 3-point Neville interpolation (as nr_polint())
+  static double polint3(const double *xa, const double *ya, double x, double *dy) {
+    double c[3], d[3], y;
+    int ns = 1;
+    double dif = std::fabs(x - xa[0]);
+    for ( int i = 0 ; i < 3 ; i++ ) {
+      double dift = std::fabs(x - xa[i]);
+      if ( dift < dif ) {
+	ns = i+1;
+	dif = dift;
+      }
+      c[i] = d[i] = ya[i];
+    }
+    y = ya[--ns];
+    for ( int m = 0 ; m < 2 ; m++ ) {
+      for ( int i = 0 ; i < 2-m ; i++ ) {
+	double ho = xa[i] - x, hp = xa[i+m+1] - x;
+	double den = (c[i+1] - d[i]) / (ho - hp);
+	d[i] = hp * den;
+	c[i] = ho * den;
+      }
+      *dy = 2*ns < 2-m ? c[ns] : d[--ns];
+      y += *dy;
+    }
+    *dy = std::fabs(*dy);
+    return y;
+  }
+
+  double range_lg(double elg, double *err) const {
+    int jj = locate(em_,elg);
+    return polint3(&em_[jj],&r_[jj],elg,err);
+  }
+
+  double energy_lg(double rng, double *err) const {
+    int jj = locate(r_,rng);
+    return polint3(&r_[jj],&em_[jj],rng,err);
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*
+  Author: Ricardo Yanez
+
+  Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+
+  Asynchronous range table prefetch. range_prefetch() submits a list
+  of table keys as tasks of the scheduler (see rangesched.c) and
+  returns at once; range_wait() blocks until all tables of the job are
+  in the table cache.
+
+  License:
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "range.h"
+#include "rangetab.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct range_job {
+  int n;
+  struct range_key *key;
+  struct range_task **task;
+};
+
+static void build(void *arg) {
+  const struct range_key *k = arg;
+  range_enter();
+  rtab_get(k->icorr,k->zp,k->ap,k->iabso,k->zt,k->at);
+  range_leave();
+}
+
+/*
+  Build the range tables of n keys in the background. Returns a job
+  handle that must be passed to range_wait().
+*/
+struct range_job *range_prefetch(const struct range_key *keys, int n) {
+
+  struct range_job *job = malloc(sizeof(struct range_job));
+  if ( job != NULL ) {
+    job->key = malloc((n > 0 ? n : 1) * sizeof(struct range_key));
+    job->task = malloc((n > 0 ? n : 1) * sizeof(struct range_task *));
+  }
+  if ( job == NULL || job->key == NULL || job->task == NULL ) {
+    fprintf(stderr,"range_prefetch: out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  job->n = n;
+  for ( int i = 0 ; i < n ; i++ ) {
+    job->key[i] = keys[i];
+    job->task[i] = range_submit(build,&job->key[i]);
+  }
+
+  return job;
+}
+
+/*
+  Block until all tables of a prefetch job are built, and release the
+  job handle.
+*/
+void range_wait(struct range_job *job) {
+  if ( job == NULL ) return;
+  for ( int i = 0 ; i < job->n ; i++ ) {
+    range_join(job->task[i]);
+  }
+  free(job->task);
+  free(job->key);
+  free(job);
+}
+
+#ifdef __cplusplus
+}
+#endif
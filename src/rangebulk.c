@@ -0,0 +1,123 @@
+/*
+  Author: Ricardo Yanez
+
+  Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+
+  Bulk range table builder. range_build() builds the tables of a list
+  of keys, typically many projectiles against a few absorbers. The
+  absorber and projectile data are calculated once per element under
+  the library lock, and the tables are then calculated without the
+  lock on several threads and published in the table cache.
+
+  License:
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#include "range.h"
+#include "rangetab.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Largest number of tasks
+#define NTHREAD 64
+
+struct bulk {
+  struct rtab *head;
+  int n, lz;
+  atomic_int next;
+  atomic_int added;
+};
+
+static void sweep(void *arg) {
+  struct bulk *b = arg;
+  int i;
+  range_enter();
+  while ( (i = atomic_fetch_add(&b->next,1)) < b->n ) {
+    struct rtab *t = rtab_make(&b->head[i],b->lz);
+    // another thread may have cached the key meanwhile, then t is freed
+    if ( rtab_put(t) == t ) atomic_fetch_add(&b->added,1);
+  }
+  range_leave();
+}
+
+/*
+  Build the range tables of n keys and save them in the table cache,
+  using nthread tasks of the scheduler, or range_concurrency() if
+  nthread is 0 or less. Keys already in the cache are skipped. Returns
+  the number of tables added to the cache.
+*/
+int range_build(const struct range_key *keys, int n, int nthread) {
+
+  struct bulk b;
+  struct range_task *task[NTHREAD];
+
+  b.head = malloc((n > 0 ? n : 1) * sizeof(struct rtab));
+  if ( b.head == NULL ) {
+    fprintf(stderr,"range_build: out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  b.n = 0;
+  b.lz = rtab_lazy();
+  atomic_init(&b.next,0);
+  atomic_init(&b.added,0);
+
+  // The absorber and projectile data are calculated here, once per element
+  range_enter();
+  range_lock();
+  for ( int i = 0 ; i < n ; i++ ) {
+    const struct range_key *k = &keys[i];
+    int dup = rtab_find(k->icorr,k->zp,k->ap,k->iabso,k->zt,k->at) != NULL;
+    for ( int j = 0 ; j < b.n && !dup ; j++ ) {
+      const struct rtab *h = &b.head[j];
+      dup = h->icorr == k->icorr && h->zp == k->zp && h->ap == k->ap &&
+	h->iabso == k->iabso && h->zt == k->zt && h->at == k->at;
+    }
+    if ( !dup ) {
+      rtab_head(&b.head[b.n++],k->icorr,k->zp,k->ap,k->iabso,k->zt,k->at);
+    }
+  }
+  range_unlock();
+  range_leave();
+
+  if ( nthread <= 0 ) {
+    nthread = range_concurrency();
+  }
+  if ( nthread > b.n ) nthread = b.n;
+  if ( nthread > NTHREAD ) nthread = NTHREAD;
+
+  for ( int i = 1 ; i < nthread ; i++ ) {
+    task[i] = range_submit(sweep,&b);
+  }
+  // The calling thread takes part, so the build completes even if no task runs yet
+  sweep(&b);
+  for ( int i = 1 ; i < nthread ; i++ ) {
+    range_join(task[i]);
+  }
+
+  free(b.head);
+  return atomic_load(&b.added);
+}
+
+#ifdef __cplusplus
+}
+#endif
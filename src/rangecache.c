@@ -0,0 +1,387 @@
+/*
+  Author: Ricardo Yanez
+
+  Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+
+  Concurrent range table cache.
+
+  Tables are published in an open addressing hash table of atomic
+  pointers. Lookups take no lock: a reader announces the current epoch
+  with range_enter(), loads the table pointer and keeps using the table
+  until range_leave(). Tables are built under the library lock, so two
+  threads missing on the same key build the table only once. When the
+  probe window of a key is full, the oldest table in it is evicted and
+  freed once no reader that could still see it remains in its epoch.
+
+  License:
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "rangetab.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of hash slots (must be a power of 2) and probe window
+#define NSAV 32768
+#define NPROBE 16
+
+// Maximum number of threads reading the cache at the same time
+#define NREADER 1024
+
+static _Atomic(struct rtab *) slot[NSAV];
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t nseq = 0;
+
+/*
+  Epoch based reclamation. Each reading thread owns a reader slot in
+  which it announces the global epoch while inside range_enter() and
+  range_leave(), or 0 when outside.
+*/
+static atomic_uint_fast64_t epoch = 1;
+
+static struct {
+  atomic_uint_fast64_t epoch;
+  atomic_int used;
+  char pad[64-sizeof(atomic_uint_fast64_t)-sizeof(atomic_int)];
+} reader[NREADER];
+
+static _Thread_local int rid = -1;
+static _Thread_local int depth = 0;
+
+static pthread_key_t rkey;
+static pthread_once_t ronce = PTHREAD_ONCE_INIT;
+
+struct retired {
+  struct rtab *t;
+  uint64_t epoch;
+  struct retired *next;
+};
+
+static struct retired *retired = NULL;
+
+void range_lock(void) {
+  pthread_mutex_lock(&lock);
+}
+
+void range_unlock(void) {
+  pthread_mutex_unlock(&lock);
+}
+
+/*
+  Give the reader slot back when the thread exits.
+*/
+static void reader_release(void *p) {
+  int id = (int)(intptr_t)p - 1;
+  atomic_store(&reader[id].epoch,0);
+  atomic_store(&reader[id].used,0);
+}
+
+static void reader_key(void) {
+  pthread_key_create(&rkey,reader_release);
+}
+
+static void reader_claim(void) {
+  pthread_once(&ronce,reader_key);
+  for ( int i = 0 ; i < NREADER ; i++ ) {
+    int unused = 0;
+    if ( atomic_compare_exchange_strong(&reader[i].used,&unused,1) ) {
+      rid = i;
+      pthread_setspecific(rkey,(void *)(intptr_t)(i+1));
+      return;
+    }
+  }
+  fprintf(stderr,"rangecache: more than %d threads reading tables\n",NREADER);
+  exit(EXIT_FAILURE);
+}
+
+/*
+  Start a read-side critical section. Table pointers returned by
+  rtab_get() remain valid until the matching range_leave().
+*/
+void range_enter(void) {
+  if ( depth++ > 0 ) return;
+  if ( rid < 0 ) reader_claim();
+  atomic_store(&reader[rid].epoch,atomic_load(&epoch));
+}
+
+void range_leave(void) {
+  if ( --depth > 0 ) return;
+  atomic_store(&reader[rid].epoch,0);
+}
+
+/*
+  Free retired tables that no reader can see anymore. Called with the
+  lock held.
+*/
+static void reclaim(void) {
+  uint64_t low = UINT64_MAX;
+  struct retired **p = &retired;
+
+  for ( int i = 0 ; i < NREADER ; i++ ) {
+    uint64_t e = atomic_load(&reader[i].epoch);
+    if ( e != 0 && e < low ) low = e;
+  }
+  while ( *p != NULL ) {
+    struct retired *q = *p;
+    if ( q->epoch < low && atomic_load(&q->t->ref) == 0 ) {
+      *p = q->next;
+      rtab_free(q->t);
+      free(q);
+    }
+    else {
+      p = &q->next;
+    }
+  }
+}
+
+static unsigned int hash(int icorr, int zp, int ap, int iabso, int zt, int at) {
+  uint64_t h = 14695981039346656037ULL;
+  int key[6] = {icorr,zp,ap,iabso,zt,at};
+  for ( int i = 0 ; i < 6 ; i++ ) {
+    h ^= (uint32_t)key[i];
+    h *= 1099511628211ULL;
+  }
+  return (unsigned int)(h ^ (h >> 32)) & (NSAV-1);
+}
+
+static const struct rtab *lookup(unsigned int h, int icorr, int zp, int ap,
+				 int iabso, int zt, int at) {
+  for ( int i = 0 ; i < NPROBE ; i++ ) {
+    const struct rtab *t = atomic_load(&slot[(h+i)&(NSAV-1)]);
+    if ( t == NULL ) return NULL;
+    if ( t->icorr == icorr && t->zp == zp && t->ap == ap &&
+	 t->iabso == iabso && t->zt == zt && t->at == at ) return t;
+  }
+  return NULL;
+}
+
+/*
+  Publish a table, evicting the oldest one in the probe window if it is
+  full. Called with the lock held.
+*/
+static void publish(unsigned int h, struct rtab *t) {
+  int victim = -1;
+  uint64_t oldest = UINT64_MAX;
+
+  t->seq = ++nseq;
+  for ( int i = 0 ; i < NPROBE ; i++ ) {
+    int k = (h+i)&(NSAV-1);
+    struct rtab *s = atomic_load(&slot[k]);
+    if ( s == NULL ) {
+      atomic_store(&slot[k],t);
+      return;
+    }
+    if ( s->seq < oldest ) {
+      oldest = s->seq;
+      victim = k;
+    }
+  }
+
+  struct retired *q = malloc(sizeof(struct retired));
+  if ( q == NULL ) {
+    fprintf(stderr,"rangecache: out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  q->t = atomic_exchange(&slot[victim],t);
+  q->epoch = atomic_fetch_add(&epoch,1);
+  q->next = retired;
+  retired = q;
+  reclaim();
+}
+
+/*
+  Build the table of an isotope from the electronic table of its
+  element (key ap = 0), building and publishing that first if it is
+  not in the cache. Called with the lock held.
+*/
+static struct rtab *scale(int mode, int icorr, int zp, int ap, int iabso, int zt, int at) {
+  unsigned int h = hash(icorr,zp,0,iabso,zt,at);
+  const struct rtab *el = lookup(h,icorr,zp,0,iabso,zt,at);
+  struct rtab head;
+
+  rtab_head(&head,icorr,zp,ap,iabso,zt,at);
+  if ( el == NULL ) {
+    struct rtab *e = rtab_make_el(&head);
+    publish(h,e);
+    el = e;
+  }
+  return rtab_scale(&head,el,mode == RANGE_SCALE_NUCLEAR);
+}
+
+/*
+  Return the range table for the given projectile and absorber,
+  building it if it is not in the cache. Must be called between
+  range_enter() and range_leave().
+*/
+const struct rtab *rtab_get(int icorr, int zp, int ap, int iabso, int zt, int at) {
+
+  unsigned int h = hash(icorr,zp,ap,iabso,zt,at);
+  const struct rtab *t;
+
+  t = lookup(h,icorr,zp,ap,iabso,zt,at);
+  if ( t != NULL ) return t;
+
+  range_lock();
+  // Another thread may have built it while we waited for the lock
+  t = lookup(h,icorr,zp,ap,iabso,zt,at);
+  if ( t == NULL ) {
+    // tables of the table pack are accurate and cheaper than scaled ones
+    int mode = rtab_pack_find(icorr,zp,ap,iabso,zt,at) ? 0 : rtab_scaling();
+    struct rtab *b = (mode && ap > 0) ? scale(mode,icorr,zp,ap,iabso,zt,at) :
+      rtab_build(icorr,zp,ap,iabso,zt,at);
+    publish(h,b);
+    t = b;
+  }
+  range_unlock();
+  return t;
+}
+
+/*
+  Publish a table built without the lock by rtab_make(). If another
+  thread published the same table first, t is freed and the table in
+  the cache is returned. Must be called between range_enter() and
+  range_leave().
+*/
+const struct rtab *rtab_put(struct rtab *t) {
+
+  unsigned int h = hash(t->icorr,t->zp,t->ap,t->iabso,t->zt,t->at);
+  const struct rtab *s;
+
+  range_lock();
+  s = lookup(h,t->icorr,t->zp,t->ap,t->iabso,t->zt,t->at);
+  if ( s == NULL ) {
+    publish(h,t);
+    s = t;
+  }
+  else {
+    rtab_free(t);
+  }
+  range_unlock();
+  return s;
+}
+
+/*
+  Return the range table for the given key if it is in the cache, or
+  NULL. Must be called between range_enter() and range_leave().
+*/
+const struct rtab *rtab_find(int icorr, int zp, int ap, int iabso, int zt, int at) {
+  return lookup(hash(icorr,zp,ap,iabso,zt,at),icorr,zp,ap,iabso,zt,at);
+}
+
+/*
+  Call f for each table in the cache. Must be called between
+  range_enter() and range_leave().
+*/
+void rtab_each(void (*f)(const struct rtab *, void *), void *arg) {
+  for ( int k = 0 ; k < NSAV ; k++ ) {
+    const struct rtab *t = atomic_load(&slot[k]);
+    if ( t != NULL ) f(t,arg);
+  }
+}
+
+/*
+  Make sure segment k of a table is built.
+*/
+void rtab_need(const struct rtab *t, int k) {
+  if ( atomic_load_explicit(&t->built[k],memory_order_acquire) ) return;
+  range_lock();
+  if ( !atomic_load_explicit(&t->built[k],memory_order_relaxed) ) {
+    rtab_segment((struct rtab *)t,k);
+  }
+  range_unlock();
+}
+
+/*
+  Make sure all segments of a table are built.
+*/
+void rtab_complete(const struct rtab *t) {
+  if ( atomic_load_explicit(&t->complete,memory_order_acquire) ) return;
+  for ( int k = 0 ; k < t->nseg ; k++ ) {
+    rtab_need(t,k);
+  }
+}
+
+/*
+  Open a handle to the complete range table of key. The table is not
+  freed while the handle is open, even if it is evicted from the cache.
+*/
+const struct range_table *range_table_open(const struct range_key *key) {
+  const struct rtab *t;
+  range_enter();
+  t = rtab_get(key->icorr,key->zp,key->ap,key->iabso,key->zt,key->at);
+  rtab_complete(t);
+  atomic_fetch_add(&((struct rtab *)t)->ref,1);
+  range_leave();
+  return (const struct range_table *)t;
+}
+
+/*
+  Build a range table for an absorber of n elements given in cmp,
+  without using absorb[] or the cache, and open a handle to it.
+*/
+const struct range_table *range_table_new(int icorr, int zp, int ap,
+					  const struct elem *cmp, int n) {
+  struct rtab h, *t;
+  if ( n < 1 || n > NELMAX ) {
+    fprintf(stderr,"range_table_new: invalid number of elements: %d\n",n);
+    exit(EXIT_FAILURE);
+  }
+  range_lock();
+  rtab_head_cmp(&h,icorr,zp,ap,cmp,n);
+  range_unlock();
+  t = rtab_make(&h,0);
+  t->priv = 1;
+  atomic_store(&t->ref,1);
+  return (const struct range_table *)t;
+}
+
+/*
+  Close a handle. A table from range_table_new() is freed when its
+  last handle is closed.
+*/
+void range_table_close(const struct range_table *tab) {
+  struct rtab *t = (struct rtab *)tab;
+  if ( t == NULL ) return;
+  if ( atomic_fetch_sub(&t->ref,1) == 1 && t->priv ) {
+    rtab_free(t);
+  }
+}
+
+/*
+  Return the number of points of a table and pointers to its log10(E/A)
+  and range (mg/cm2) columns.
+*/
+int range_table_data(const struct range_table *tab, const double **em,
+		     const double **r) {
+  const struct rtab *t = (const struct rtab *)tab;
+  *em = t->em;
+  *r = t->r;
+  return t->n;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,276 @@
+/*
+  Author: Ricardo Yanez
+
+  Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+
+  Compact range tables. The range-energy curve of a range table is
+  approximated by piecewise Chebyshev series, log10(R) in terms of
+  log10(E/A) and log10(E/A) in terms of log10(R), on segments chosen by
+  bisection until the series agree with the table within a given
+  relative error. The series are evaluated with the Clenshaw recurrence.
+
+  License:
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "rangetab.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of Chebyshev coefficients per segment
+#define NCHEB 10
+
+// Default relative error
+#define CHEB_TOL 1.0e-6
+
+// Smallest relative error, the smoothness of the range table
+#define CHEB_TOLMIN 1.0e-7
+
+// Narrowest segment, in decades
+#define CHEB_MIN 0.02
+
+/*
+  Piecewise Chebyshev series of a function on [x[0],x[n]]. Segment k
+  covers [x[k],x[k+1]] with coefficients c[k*NCHEB...].
+*/
+struct cheb {
+  int n, size;
+  double *x;
+  double *c;
+};
+
+struct range_cheb {
+  int ap;
+  struct cheb fwd;  // log10(R) of log10(E/A)
+  struct cheb inv;  // log10(E/A) of log10(R)
+};
+
+/*
+  Sum a Chebyshev series at t in [-1,1].
+*/
+static inline double clenshaw(const double *c, double t) {
+  double b1 = 0.0, b2 = 0.0, t2 = 2.0 * t;
+  for ( int k = NCHEB-1 ; k > 0 ; k-- ) {
+    double b0 = c[k] + t2 * b1 - b2;
+    b2 = b1;
+    b1 = b0;
+  }
+  return c[0] + t * b1 - b2;
+}
+
+/*
+  Evaluate a piecewise series. Outside [x[0],x[n]] the first or last
+  segment is extrapolated.
+*/
+static inline double cheb_eval(const struct cheb *s, double x) {
+  int lo = 0, hi = s->n;
+  while ( hi - lo > 1 ) {
+    int m = (lo + hi) / 2;
+    if ( x >= s->x[m] )
+      lo = m;
+    else
+      hi = m;
+  }
+  double a = s->x[lo], b = s->x[lo+1];
+  return clenshaw(&s->c[lo*NCHEB],(2.0 * x - a - b) / (b - a));
+}
+
+/*
+  The function being fitted: log10(R) of log10(E/A) if dir is 0, or
+  log10(E/A) of log10(R) if dir is 1, interpolated in the range table.
+*/
+static double tab_eval(const struct rtab *t, int dir, double x) {
+  double err;
+  if ( dir == 0 ) return log10(rtab_range(t,x,&err));
+  return rtab_energy(t,pow(10.0,x),&err);
+}
+
+static double tab_node(const struct rtab *t, int dir, int j) {
+  return dir == 0 ? t->em[j] : log10(t->r[j]);
+}
+
+static void cheb_push(struct cheb *s, double a, double b, const double *c) {
+  if ( s->n == s->size ) {
+    s->size = s->size ? 2 * s->size : 16;
+    s->x = realloc(s->x,(s->size+1)*sizeof(double));
+    s->c = realloc(s->c,s->size*NCHEB*sizeof(double));
+    if ( s->x == NULL || s->c == NULL ) {
+      fprintf(stderr,"range_cheb: out of memory\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  s->x[s->n] = a;
+  s->x[s->n+1] = b;
+  for ( int k = 0 ; k < NCHEB ; k++ ) {
+    s->c[s->n*NCHEB+k] = k == 0 ? 0.5 * c[0] : c[k];
+  }
+  s->n++;
+}
+
+/*
+  Fit the function on [a,b] and check it at the table points inside
+  and half way between them. If the error is above tol the interval is
+  bisected, down to CHEB_MIN decades. Narrower segments are kept
+  without the check and may exceed tol.
+*/
+static void cheb_fit(struct cheb *s, const struct rtab *t, int dir,
+		     double a, double b, double tol) {
+
+  double f[NCHEB], c[NCHEB], p[NCHEB];
+
+  for ( int k = 0 ; k < NCHEB ; k++ ) {
+    double x = 0.5 * (a + b) + 0.5 * (b - a) * cos(M_PI * (k + 0.5) / NCHEB);
+    f[k] = tab_eval(t,dir,x);
+  }
+  for ( int j = 0 ; j < NCHEB ; j++ ) {
+    double sum = 0.0;
+    for ( int k = 0 ; k < NCHEB ; k++ ) {
+      sum += f[k] * cos(M_PI * j * (k + 0.5) / NCHEB);
+    }
+    c[j] = 2.0 * sum / NCHEB;
+  }
+  for ( int k = 0 ; k < NCHEB ; k++ ) {
+    p[k] = k == 0 ? 0.5 * c[0] : c[k];
+  }
+
+  if ( b - a > CHEB_MIN ) {
+    double xold = a;
+    for ( int j = 0 ; j < t->n ; j++ ) {
+      double xj = tab_node(t,dir,j);
+      if ( xj <= a ) continue;
+      if ( xj > b ) xj = b;
+      for ( int h = 0 ; h < 2 ; h++ ) {
+	double x = h == 0 ? 0.5 * (xold + xj) : xj;
+	double y = clenshaw(p,(2.0 * x - a - b) / (b - a));
+	if ( fabs(y - tab_eval(t,dir,x)) > tol ) {
+	  double m = 0.5 * (a + b);
+	  cheb_fit(s,t,dir,a,m,tol);
+	  cheb_fit(s,t,dir,m,b,tol);
+	  return;
+	}
+      }
+      if ( xj == b ) break;
+      xold = xj;
+    }
+  }
+  cheb_push(s,a,b,c);
+}
+
+/*
+  Build the compact table of a projectile and absorber. tol is the
+  relative error in range and energy with respect to the range table,
+  or the default 1e-6 if tol <= 0. The range table is only smooth to
+  about 1e-7, so smaller errors only add segments and are taken as
+  CHEB_TOLMIN. The correlation is
+  not switched with the energy, use icorr = 2 to cover all energies.
+*/
+struct range_cheb *range_cheb_new(int icorr, int zp, int ap, int iabso,
+				  int zt, int at, double tol) {
+
+  struct range_cheb *rc = calloc(1,sizeof(struct range_cheb));
+  const struct rtab *t;
+  double a, b;
+
+  if ( rc == NULL ) {
+    fprintf(stderr,"range_cheb: out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  if ( tol <= 0.0 ) tol = CHEB_TOL;
+  if ( tol < CHEB_TOLMIN ) tol = CHEB_TOLMIN;
+  // error in log10
+  tol = tol / log(10.0);
+
+  rc->ap = ap;
+  range_enter();
+  t = rtab_get(icorr,zp,ap,iabso,zt,at);
+  rtab_complete(t);
+
+  /* H-B-G tables switch to N-S at 2.5 MeV/A, where the slope jumps */
+  a = t->em[0];
+  b = t->em[t->n-1];
+  if ( icorr == 1 && a < log10(2.5) ) {
+    double xs = log10(2.5);
+    double err, rs = log10(rtab_range(t,xs,&err));
+    cheb_fit(&rc->fwd,t,0,a,xs,tol);
+    cheb_fit(&rc->fwd,t,0,xs,b,tol);
+    cheb_fit(&rc->inv,t,1,log10(t->r[0]),rs,tol);
+    cheb_fit(&rc->inv,t,1,rs,log10(t->r[t->n-1]),tol);
+  }
+  else {
+    cheb_fit(&rc->fwd,t,0,a,b,tol);
+    cheb_fit(&rc->inv,t,1,log10(t->r[0]),log10(t->r[t->n-1]),tol);
+  }
+  range_leave();
+
+  return rc;
+}
+
+void range_cheb_free(struct range_cheb *rc) {
+  if ( rc == NULL ) return;
+  free(rc->fwd.x);
+  free(rc->fwd.c);
+  free(rc->inv.x);
+  free(rc->inv.c);
+  free(rc);
+}
+
+/*
+  Memory used by the series, in bytes.
+*/
+size_t range_cheb_size(const struct range_cheb *rc) {
+  return (rc->fwd.n + rc->inv.n) * (NCHEB + 1) * sizeof(double);
+}
+
+/*
+  Range (mg/cm2) of an ion of energy ein (MeV).
+*/
+double range_cheb_range(const struct range_cheb *rc, double ein) {
+  return pow(10.0,cheb_eval(&rc->fwd,log10(ein/rc->ap)));
+}
+
+/*
+  Energy (MeV) of an ion of range rng (mg/cm2).
+*/
+double range_cheb_energy(const struct range_cheb *rc, double rng) {
+  if ( rng <= 0.0 ) return 0.0;
+  return pow(10.0,cheb_eval(&rc->inv,log10(rng))) * rc->ap;
+}
+
+/*
+  Energy (MeV) of an ion of energy ein after passage through an
+  absorber foil of thickness t (mg/cm2).
+*/
+double range_cheb_passage(const struct range_cheb *rc, double ein, double t) {
+  return range_cheb_energy(rc,range_cheb_range(rc,ein) - t);
+}
+
+void range_cheb_passage_v(const struct range_cheb *rc, int n, const double *ein,
+			  const double *t, double *eut) {
+  for ( int i = 0 ; i < n ; i++ ) {
+    eut[i] = range_cheb_passage(rc,ein[i],t[i]);
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,239 @@
+/*
+  Author: Ricardo Yanez
+
+  Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+
+  Export of range tables as C source. range_emit_c() writes a header
+  holding the tables of a list of keys as constant arrays, with inline
+  functions doing the lookups of passage(), egassap(), rangen() and
+  thickn() on them, for programs that cannot link librange or build
+  tables at startup. The header needs only <math.h>.
+
+  License:
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "range.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static int same(const struct range_key *p, const struct range_key *q) {
+  return p->icorr == q->icorr && p->zp == q->zp && p->ap == q->ap &&
+    p->iabso == q->iabso && p->zt == q->zt && p->at == q->at;
+}
+
+static void emit_array(FILE *fp, const char *name, int k, const double *x, int n) {
+  fprintf(fp,"RANGE_C_CONST double %s_%d[%d] = {",name,k,n);
+  for ( int j = 0 ; j < n ; j++ ) {
+    fprintf(fp,"%s%.17g",j % 4 ? ", " : (j ? ",\n  " : "\n  "),x[j]);
+  }
+  fprintf(fp,"};\n\n");
+}
+
+static const char *lookups =
+  "/* Index of the last point below x, as nr_locate() */\n"
+  "static inline int range_c_locate(const double *y, int n, double x) {\n"
+  "  int jl = 0, ju = n;\n"
+  "  while ( ju - jl > 1 ) {\n"
+  "    int jm = (ju + jl) / 2;\n"
+  "    if ( x > y[jm] ) jl = jm; else ju = jm;\n"
+  "  }\n"
+  "  return jl > n-3 ? n-3 : jl;\n"
+  "}\n\n"
+  "/* 3-point Neville interpolation, as nr_polint() */\n"
+  "static inline double range_c_polint(const double *xa, const double *ya,\n"
+  "\t\t\t\t    double x, double *dy) {\n"
+  "  double c[3], d[3], y;\n"
+  "  int ns = 1;\n"
+  "  double dif = fabs(x - xa[0]);\n"
+  "  for ( int i = 0 ; i < 3 ; i++ ) {\n"
+  "    double dift = fabs(x - xa[i]);\n"
+  "    if ( dift < dif ) { ns = i+1; dif = dift; }\n"
+  "    c[i] = d[i] = ya[i];\n"
+  "  }\n"
+  "  y = ya[--ns];\n"
+  "  for ( int m = 0 ; m < 2 ; m++ ) {\n"
+  "    for ( int i = 0 ; i < 2-m ; i++ ) {\n"
+  "      double ho = xa[i] - x, hp = xa[i+m+1] - x;\n"
+  "      double den = (c[i+1] - d[i]) / (ho - hp);\n"
+  "      d[i] = hp * den;\n"
+  "      c[i] = ho * den;\n"
+  "    }\n"
+  "    *dy = 2*ns < 2-m ? c[ns] : d[--ns];\n"
+  "    y += *dy;\n"
+  "  }\n"
+  "  *dy = fabs(*dy);\n"
+  "  return y;\n"
+  "}\n\n"
+  "static inline double range_c_range(const struct range_c_tab *t, double elg, double *err) {\n"
+  "  int jj = range_c_locate(t->em,t->n,elg);\n"
+  "  return range_c_polint(&t->em[jj],&t->r[jj],elg,err);\n"
+  "}\n\n"
+  "static inline double range_c_energy(const struct range_c_tab *t, double rng, double *err) {\n"
+  "  int jj = range_c_locate(t->r,t->n,rng);\n"
+  "  return range_c_polint(&t->r[jj],&t->em[jj],rng,err);\n"
+  "}\n\n"
+  "/* The table of a key, or NULL */\n"
+  "static inline const struct range_c_tab *range_c_find(int icorr, int zp, int ap,\n"
+  "\t\t\t\t\t\t     int iabso, int zt, int at) {\n"
+  "  for ( int k = 0 ; k < RANGE_C_NTAB ; k++ ) {\n"
+  "    const struct range_c_tab *t = &range_c_tabs[k];\n"
+  "    if ( t->icorr == icorr && t->zp == zp && t->ap == ap &&\n"
+  "\t t->iabso == iabso && t->zt == zt && t->at == at ) return t;\n"
+  "  }\n"
+  "  return NULL;\n"
+  "}\n\n"
+  "/* As passage(), NaN if the table was not exported */\n"
+  "static inline double range_c_passage(int icorr, int zp, int ap, int iabso, int zt, int at,\n"
+  "\t\t\t\t     double ein, double t, double *err) {\n"
+  "  const struct range_c_tab *tab;\n"
+  "  double lerr, rut, elut, eu;\n"
+  "  if ( icorr == 0 && ein/ap > 12.0 ) icorr = 1;\n"
+  "  if ( icorr == 1 && ein/ap <= 2.5 ) icorr = 0;\n"
+  "  tab = range_c_find(icorr,zp,ap,iabso,zt,at);\n"
+  "  if ( tab == NULL ) return NAN;\n"
+  "  rut = range_c_range(tab,log10(ein/ap),&lerr) - t;\n"
+  "  if ( rut <= 0.0 ) {\n"
+  "    if ( err ) *err = 0.0;\n"
+  "    return 0.0;\n"
+  "  }\n"
+  "  elut = range_c_energy(tab,rut,&lerr);\n"
+  "  eu = pow(10.0,elut);\n"
+  "  if ( err ) *err = fabs(pow(10.0,elut-lerr*3)-pow(10.0,elut+lerr*3))/eu;\n"
+  "  return eu*ap;\n"
+  "}\n\n"
+  "/* As egassap(), without its warnings, NaN if the table was not exported */\n"
+  "static inline double range_c_egassap(int icorr, int zp, int ap, int iabso, int zt, int at,\n"
+  "\t\t\t\t     double t, double eut, double *err) {\n"
+  "  const struct range_c_tab *tab;\n"
+  "  double lerr, rut = 0.0, elin, ei;\n"
+  "  if ( eut/ap != 0.0 && icorr == 0 && eut/ap > 12.0 ) icorr = 1;\n"
+  "  tab = range_c_find(icorr,zp,ap,iabso,zt,at);\n"
+  "  if ( tab == NULL ) return NAN;\n"
+  "  if ( eut/ap != 0.0 ) rut = range_c_range(tab,log10(eut/ap),&lerr);\n"
+  "  elin = range_c_energy(tab,rut+t,&lerr);\n"
+  "  ei = pow(10.0,elin);\n"
+  "  if ( err ) *err = fabs(pow(10.0,elin-lerr*3)-pow(10.0,elin+lerr*3))/ei;\n"
+  "  return ei*ap;\n"
+  "}\n\n"
+  "/* As rangen(), NaN if the table was not exported */\n"
+  "static inline double range_c_rangen(int icorr, int zp, int ap, int iabso, int zt, int at,\n"
+  "\t\t\t\t    double ein) {\n"
+  "  const struct range_c_tab *tab;\n"
+  "  double rerr;\n"
+  "  if ( icorr == 0 && ein/ap > 12.0 ) icorr = 1;\n"
+  "  if ( icorr == 1 && ein/ap <= 2.5 ) icorr = 0;\n"
+  "  tab = range_c_find(icorr,zp,ap,iabso,zt,at);\n"
+  "  if ( tab == NULL ) return NAN;\n"
+  "  return range_c_range(tab,log10(ein/ap),&rerr);\n"
+  "}\n\n"
+  "/* As thickn(), NaN if the table was not exported */\n"
+  "static inline double range_c_thickn(int icorr, int zp, int ap, int iabso, int zt, int at,\n"
+  "\t\t\t\t    double ein, double delen) {\n"
+  "  const struct range_c_tab *tab;\n"
+  "  double rerr, rut = 0.0;\n"
+  "  if ( icorr == 0 && ein/ap > 12.0 ) icorr = 1;\n"
+  "  if ( icorr == 1 && ein/ap <= 2.5 ) icorr = 0;\n"
+  "  tab = range_c_find(icorr,zp,ap,iabso,zt,at);\n"
+  "  if ( tab == NULL ) return NAN;\n"
+  "  if ( ein-delen > 0.0 ) rut = range_c_range(tab,log10((ein-delen)/ap),&rerr);\n"
+  "  return range_c_range(tab,log10(ein/ap),&rerr) - rut;\n"
+  "}\n\n";
+
+/*
+  Write to fp a C header with the range tables of n keys. A key with
+  icorr 0 or 1 exports the tables of both correlations, as passage()
+  switches between them with the energy. User defined compounds are
+  exported as they are defined in absorb[] at the time of the call.
+  Returns the number of tables written.
+*/
+int range_emit_c(FILE *fp, const struct range_key *keys, int n) {
+
+  struct range_key *tab = malloc((2*n > 0 ? 2*n : 1)*sizeof(struct range_key));
+  int ntab = 0;
+
+  if ( tab == NULL ) {
+    fprintf(stderr,"range_emit_c: out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  for ( int i = 0 ; i < n ; i++ ) {
+    for ( int c = 0 ; c < 2 ; c++ ) {
+      struct range_key k = keys[i];
+      int dup = 0;
+      if ( c == 1 ) {
+	if ( k.icorr == 2 ) break;
+	k.icorr = 1 - k.icorr;
+      }
+      for ( int j = 0 ; j < ntab && !dup ; j++ ) {
+	dup = same(&tab[j],&k);
+      }
+      if ( !dup ) tab[ntab++] = k;
+    }
+  }
+
+  fprintf(fp,"/*\n  Range tables exported by rangelib, range_emit_c().\n");
+  fprintf(fp,"  The functions range_c_passage(), range_c_egassap(), range_c_rangen() and\n"
+	  "  range_c_thickn() take the arguments of passage(), egassap(), rangen()\n"
+	  "  and thickn(), and return NaN for a table that was not exported.\n*/\n\n");
+  fprintf(fp,"#ifndef RANGE_C_TABLES\n#define RANGE_C_TABLES\n\n#include <stddef.h>\n#include <math.h>\n\n");
+  fprintf(fp,"#if defined(__cplusplus) && __cplusplus >= 201103L\n"
+	  "# define RANGE_C_CONST static constexpr\n"
+	  "#else\n"
+	  "# define RANGE_C_CONST static const\n"
+	  "#endif\n\n");
+  fprintf(fp,"/* icorr zp ap iabso zt at */\n");
+
+  for ( int k = 0 ; k < ntab ; k++ ) {
+    const struct range_table *t = range_table_open(&tab[k]);
+    const double *em, *r;
+    int m = range_table_data(t,&em,&r);
+    fprintf(fp,"/* %d %d %d %d %d %d */\n",tab[k].icorr,tab[k].zp,tab[k].ap,
+	    tab[k].iabso,tab[k].zt,tab[k].at);
+    emit_array(fp,"range_c_em",k,em,m);
+    emit_array(fp,"range_c_r",k,r,m);
+    range_table_close(t);
+  }
+
+  fprintf(fp,"struct range_c_tab {\n  int icorr, zp, ap, iabso, zt, at, n;\n"
+	  "  const double *em, *r;\n};\n\n");
+  fprintf(fp,"#define RANGE_C_NTAB %d\n\n",ntab);
+  fprintf(fp,"static const struct range_c_tab range_c_tabs[RANGE_C_NTAB] = {\n");
+  for ( int k = 0 ; k < ntab ; k++ ) {
+    const struct range_table *t = range_table_open(&tab[k]);
+    const double *em, *r;
+    int m = range_table_data(t,&em,&r);
+    range_table_close(t);
+    fprintf(fp,"  {%d,%d,%d,%d,%d,%d,%d,range_c_em_%d,range_c_r_%d}%s\n",
+	    tab[k].icorr,tab[k].zp,tab[k].ap,tab[k].iabso,tab[k].zt,tab[k].at,
+	    m,k,k,k < ntab-1 ? "," : "");
+  }
+  fprintf(fp,"};\n\n");
+  fputs(lookups,fp);
+  fprintf(fp,"#endif\n");
+
+  free(tab);
+  return ntab;
+}
+
+#ifdef __cplusplus
+}
+#endif
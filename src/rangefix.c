@@ -0,0 +1,343 @@
+/*
+  Author: Ricardo Yanez
+
+  Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+
+  Fixed-point energy-loss tables for integer energies. A table maps an
+  energy code x, in units of lsb MeV, to the energy code after (or
+  before) a stack of layers. It holds the result at every 2^shift
+  codes with FIX_FRAC fractional bits, and a lookup is an integer index
+  and a linear interpolation. The step is the one that keeps the
+  interpolation error within the requested tolerance with the fewest
+  entries, and the codes just above the first, where the result bends
+  too much for it, are held rounded one by one.
+
+  License:
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "range.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fractional bits of the table entries
+#define FIX_FRAC 8
+
+// Entries of the coarsest table tried
+#define FIX_NMIN 64
+
+// Default tolerance (codes)
+#define FIX_TOL 0.25
+
+// Steps checked at every code above the direct table
+#define FIX_NFULL 4
+
+// Codes checked in each of those steps, at most 2^FIX_NFULL_BITS
+#define FIX_NFULL_BITS 12
+
+// Largest energy code, so that the entries fit in 32 bits
+#define FIX_XMAX (UINT32_MAX - 2)
+
+struct range_fix {
+  int dir;
+  uint32_t xmin;  // first code with a nonzero result
+  uint32_t xlo;   // first code of the stepped table
+  uint32_t xmax;
+  int shift;
+  uint32_t nent;
+  double err;     // largest interpolation error (codes)
+  uint32_t *d;    // rounded result at x = xmin to xlo - 1
+  uint32_t *y;    // result at x = xlo + k*2^shift, times 2^FIX_FRAC
+};
+
+/*
+  Energy (MeV) after (dir RANGE_FIX_PASSAGE) or before (RANGE_FIX_EGASSAP)
+  the layers, of an ion of energy e before or after them.
+*/
+static double stack(int icorr, int zp, int ap, const struct range_layer *layer,
+		    int nlayer, int dir, double e) {
+  double err;
+  if ( dir == RANGE_FIX_PASSAGE ) {
+    for ( int l = 0 ; l < nlayer && e > 0.0 ; l++ ) {
+      e = passage(icorr,zp,ap,layer[l].iabso,layer[l].zt,layer[l].at,e,layer[l].t,&err);
+    }
+  }
+  else {
+    for ( int l = nlayer-1 ; l >= 0 ; l-- ) {
+      double t = layer[l].t, ei;
+      egassap_v(icorr,zp,ap,layer[l].iabso,layer[l].zt,layer[l].at,1,&t,&e,&ei,NULL);
+      e = ei;
+    }
+  }
+  return e;
+}
+
+/*
+  Interpolated result at x before the final rounding, in units of
+  2^-FIX_FRAC codes.
+*/
+static inline int64_t interp(const uint32_t *y, int shift, uint32_t x) {
+  uint32_t k = x >> shift;
+  int64_t f = x & ((1u << shift) - 1);
+  int64_t y0 = y[k], y1 = y[k+1];
+  return y0 + (((y1 - y0) * f) >> shift);
+}
+
+/*
+  Result at code x, in codes.
+*/
+static double exact(int icorr, int zp, int ap, const struct range_layer *layer,
+		    int nlayer, int dir, double lsb, uint64_t x) {
+  double e = x * lsb;
+  double y = stack(icorr,zp,ap,layer,nlayer,dir,e) / lsb;
+  if ( !(y >= 0.0 && y < (double)UINT32_MAX / (1 << FIX_FRAC)) ) {
+    fprintf(stderr,"range_fix: result of %g MeV out of range\n",e);
+    exit(EXIT_FAILURE);
+  }
+  return y;
+}
+
+/*
+  Largest error of step k of a table with entries y[] from code x0, at
+  every code of the step, or at 2^FIX_NFULL_BITS evenly spaced codes
+  of longer steps.
+*/
+static double step_error(const struct range_fix *fx, const uint32_t *y, uint32_t x0,
+			 uint32_t k, int icorr, int zp, int ap,
+			 const struct range_layer *layer, int nlayer, double lsb) {
+  double err = 0.0;
+  int sub = fx->shift > FIX_NFULL_BITS ? fx->shift - FIX_NFULL_BITS : 0;
+  for ( uint64_t q = 0 ; q < (1u << (fx->shift - sub)) ; q++ ) {
+    uint64_t x = ((uint64_t)k << fx->shift) + (q << sub);
+    if ( x0 + x > fx->xmax ) break;
+    double yx = exact(icorr,zp,ap,layer,nlayer,fx->dir,lsb,x0 + x);
+    double yi = interp(y,fx->shift,(uint32_t)x) / (double)(1 << FIX_FRAC);
+    err = fmax(err,fabs(yi - yx));
+  }
+  return err;
+}
+
+/*
+  Fill a table with step 2^shift from xmin. The result bends most
+  above xmin, so the steps there whose error exceeds tol are left to
+  the direct table, and the first FIX_NFULL steps after them are
+  checked at every code. The other steps are sampled at a quarter, half
+  and three quarters of the step. Sets xlo, the stepped entries and the
+  error, and returns the size of the table in entries.
+*/
+static uint64_t fill(struct range_fix *fx, int icorr, int zp, int ap,
+		     const struct range_layer *layer, int nlayer, double lsb, double tol) {
+
+  int shift = fx->shift;
+  int sub = shift < 2 ? 0 : shift - 2;
+  uint32_t nent = (uint32_t)(((uint64_t)(fx->xmax - fx->xmin) >> shift) + 2);
+  uint32_t *y = malloc(nent*sizeof(uint32_t));
+  double *serr = malloc(nent*sizeof(double));
+  uint32_t k0 = 0;
+  uint64_t xlo;
+
+  if ( y == NULL || serr == NULL ) {
+    fprintf(stderr,"range_fix: out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  for ( uint32_t k = 0 ; k < nent ; k++ ) {
+    double yx = exact(icorr,zp,ap,layer,nlayer,fx->dir,lsb,fx->xmin + ((uint64_t)k << shift));
+    y[k] = (uint32_t)lround(yx * (1 << FIX_FRAC));
+    serr[k] = fabs(y[k] / (double)(1 << FIX_FRAC) - yx);
+  }
+  for ( uint32_t k = 0 ; k + 1 < nent ; k++ ) {
+    for ( int q = 1 ; q < (1 << (shift - sub)) ; q++ ) {
+      uint64_t x = ((uint64_t)k << shift) + ((uint64_t)q << sub);
+      if ( fx->xmin + x > fx->xmax ) break;
+      double yx = exact(icorr,zp,ap,layer,nlayer,fx->dir,lsb,fx->xmin + x);
+      double yi = interp(y,shift,(uint32_t)x) / (double)(1 << FIX_FRAC);
+      serr[k] = fmax(serr[k],fabs(yi - yx));
+    }
+    if ( serr[k] > tol ) k0 = k + 1;
+  }
+
+  // the first steps above the direct table, at every code
+  for ( uint32_t k = k0, pass = 0 ; k + 1 < nent && pass < FIX_NFULL ; k++ ) {
+    serr[k] = fmax(serr[k],step_error(fx,y,fx->xmin,k,icorr,zp,ap,layer,nlayer,lsb));
+    if ( serr[k] > tol ) {
+      k0 = k + 1;
+      pass = 0;
+    }
+    else
+      pass++;
+  }
+
+  fx->err = 0.0;
+  for ( uint32_t k = k0 ; k + 1 < nent ; k++ ) {
+    fx->err = fmax(fx->err,serr[k]);
+  }
+  free(serr);
+  free(fx->y);
+  xlo = fx->xmin + ((uint64_t)k0 << shift);
+  fx->xlo = xlo > fx->xmax ? fx->xmax + 1 : (uint32_t)xlo;
+  fx->nent = nent - k0;
+  fx->y = memmove(y,y + k0,fx->nent*sizeof(uint32_t));
+  return (uint64_t)(fx->xlo - fx->xmin) + fx->nent;
+}
+
+/*
+  Build the table of an ion through nlayer layers for energy codes 0 to
+  xmax in units of lsb MeV, with an interpolation error of at most tol
+  codes, or FIX_TOL if tol <= 0. The error cannot be smaller than the
+  rounding of the entries, 2^-(FIX_FRAC+1) codes. Of the steps tried,
+  the one with the smallest table is kept.
+*/
+struct range_fix *range_fix_new(int icorr, int zp, int ap,
+				const struct range_layer *layer, int nlayer,
+				int dir, double lsb, uint32_t xmax, double tol) {
+
+  struct range_fix *fx = malloc(sizeof(struct range_fix));
+  struct range_fix best;
+  uint64_t size, nbest = UINT64_MAX;
+  int shift;
+
+  if ( fx == NULL ) {
+    fprintf(stderr,"range_fix: out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  if ( (dir != RANGE_FIX_PASSAGE && dir != RANGE_FIX_EGASSAP) || lsb <= 0.0 ||
+       nlayer < 1 || xmax > FIX_XMAX ) {
+    fprintf(stderr,"range_fix: invalid arguments\n");
+    exit(EXIT_FAILURE);
+  }
+  if ( tol <= 0.0 ) tol = FIX_TOL;
+  fx->dir = dir;
+  fx->xmin = 0;
+  fx->xmax = xmax;
+  fx->y = NULL;
+  fx->d = NULL;
+
+  /*
+    An ion stopped in the layers leaves 0, and the result rises steeply
+    above the energy that punches through, so the table starts there.
+  */
+  if ( dir == RANGE_FIX_PASSAGE ) {
+    uint32_t lo = 0, hi = xmax;
+    if ( stack(icorr,zp,ap,layer,nlayer,dir,xmax*lsb) > 0.0 ) {
+      while ( hi - lo > 1 ) {
+	uint32_t mid = lo + (hi - lo) / 2;
+	if ( stack(icorr,zp,ap,layer,nlayer,dir,mid*lsb) > 0.0 )
+	  hi = mid;
+	else
+	  lo = mid;
+      }
+    }
+    fx->xmin = hi;
+  }
+
+  /*
+    From the coarsest step down, until the direct table is empty or the
+    stepped table alone is larger than the smallest so far.
+  */
+  best.y = NULL;
+  for ( shift = 0 ; ((uint64_t)(xmax - fx->xmin) >> shift) > FIX_NMIN ; shift++ );
+  for ( ; shift >= 0 && ((uint64_t)(xmax - fx->xmin) >> shift) < nbest ; shift-- ) {
+    fx->shift = shift;
+    size = fill(fx,icorr,zp,ap,layer,nlayer,lsb,tol);
+    if ( size < nbest ) {
+      free(best.y);
+      best = *fx;
+      fx->y = NULL;
+      nbest = size;
+    }
+    if ( fx->xlo == fx->xmin ) break;
+  }
+  free(fx->y);
+  *fx = best;
+
+  // the codes below the stepped table, rounded
+  if ( fx->xlo > fx->xmin ) {
+    fx->d = malloc((size_t)(fx->xlo - fx->xmin)*sizeof(uint32_t));
+    if ( fx->d == NULL ) {
+      fprintf(stderr,"range_fix: out of memory\n");
+      exit(EXIT_FAILURE);
+    }
+    for ( uint32_t x = fx->xmin ; x < fx->xlo ; x++ ) {
+      fx->d[x - fx->xmin] = (uint32_t)lround(exact(icorr,zp,ap,layer,nlayer,dir,lsb,x));
+    }
+  }
+
+  return fx;
+}
+
+void range_fix_free(struct range_fix *fx) {
+  if ( fx == NULL ) return;
+  free(fx->d);
+  free(fx->y);
+  free(fx);
+}
+
+/*
+  Largest interpolation error of the table in codes. The rounding of a
+  result to an integer code adds up to 0.5.
+*/
+double range_fix_error(const struct range_fix *fx) {
+  return fx->err;
+}
+
+size_t range_fix_size(const struct range_fix *fx) {
+  return ((size_t)(fx->xlo - fx->xmin) + fx->nent) * sizeof(uint32_t);
+}
+
+/*
+  Result for energy code x, rounded to the nearest code, or UINT32_MAX
+  if x is above the table.
+*/
+static inline uint32_t lookup(const struct range_fix *fx, uint32_t x) {
+  if ( x > fx->xmax ) return UINT32_MAX;
+  if ( x < fx->xmin ) return 0;
+  if ( x < fx->xlo ) return fx->d[x - fx->xmin];
+  return (uint32_t)((interp(fx->y,fx->shift,x - fx->xlo) + (1 << (FIX_FRAC-1))) >> FIX_FRAC);
+}
+
+uint32_t range_fix(const struct range_fix *fx, uint32_t x) {
+  return lookup(fx,x);
+}
+
+/*
+  Results for n energy codes. Codes above the table give UINT32_MAX,
+  and in range_fix_u16() results above 0xffff give 0xffff.
+*/
+void range_fix_u32(const struct range_fix *fx, const uint32_t *x, uint32_t *y, int n) {
+  for ( int i = 0 ; i < n ; i++ ) {
+    y[i] = lookup(fx,x[i]);
+  }
+}
+
+void range_fix_u16(const struct range_fix *fx, const uint16_t *x, uint16_t *y, int n) {
+  for ( int i = 0 ; i < n ; i++ ) {
+    uint32_t r = lookup(fx,x[i]);
+    y[i] = r > 0xffff ? 0xffff : (uint16_t)r;
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
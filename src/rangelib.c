@@ -41,20 +41,27 @@
 # define NMAX 4000
 #endif
 
-#define NSAV 20000
+// Points per block of the array stopping power routines
+#define NBLK 64
+
+// log10(2.5) and log10(12), limits of the correlations in E/A
+#define LG25 0.3979400086720376
+#define LG12 1.0791812460476249
 
 #include "range.h"
+#include "rangetab.h"
 #include "nr.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+int nelem;
+struct elem absorb[NELMAX];
+
 struct elem cmpnd[NELMAX];
 int numel;
 
-bool isw1 = false;
-bool isw2 = false;
 bool isw3 = false;
 bool isw4 = false;
 bool isw5 = false;
@@ -66,6 +73,8 @@ bool isw5 = false;
 */
 void def_absorber(int zt, int at, int iabso) {
 
+  TRACE_BEGIN(t0);
+
   switch(iabso) {
 
   // User defined
@@ -198,6 +207,8 @@ void def_absorber(int zt, int at, int iabso) {
     fprintf(stderr,"No valid absorber data.\n");
     exit(EXIT_FAILURE);
   }
+
+  TRACE_END(t0,"def_absorber","\"iabso\":%d,\"zt\":%d",iabso,zt);
 }
 
 /*
@@ -742,119 +753,44 @@ void mpyers(double *le, int zt, double *f) {
 }
 
 /*
-  Compute the "electrical" energy loss rate in any material
-  (-dE/dx)/Z2.
+  Points of the aluminium data pool, in log10(E/A).
 */
-double ededx(double e, int zp, int zt) {
-
-  double elog[42] = {-1.903089986992,-1.795880017344,-1.698970004336,-1.602059991328,-1.494850021680,
-                     -1.397940008672,-1.301029995664,-1.221848749616,-1.154901959986,-1.096910013008,
-		     -1.045757490561,-1.000000000000,-0.903089986992,-0.795880017344,-0.698970004336,
-		     -0.602059991328,-0.494850021680,-0.397940008672,-0.301029995664,-0.221848749616,
-		     -0.154901959986,-0.096910013008,-0.045757490561,+0.000000000000,+0.096910013008,
-		     +0.204119982656,+0.301029995664,+0.397940008672,+0.505149978320,+0.602059991328,
-		     +0.698970004336,+0.778151250384,+0.845098040014,+0.903089986992,+0.954242509439,
-		     +1.000000000000,+1.041392685158,+1.079181246048,+1.301029995664,+1.602059991328,
-		     +1.845098040014,+2.000000000000};
-
-  int zgases[11] = {1,2,7,8,9,10,17,18,36,54,86};
-
-  unsigned int jj;
-  static double dedxz2[42];
-  static double ak, a, ftargl;
-  double b, ftarg, el, err;
-  int gas;
-
-  if ( !isw1 ) {
-    alion(zp,&dedxz2[0]);
-    ak = (dedxz2[2] - dedxz2[0]) / (elog[2] - elog[0]);
-    a = dedxz2[0] - ak * elog[0];
-
-    // Is it a gas?
-    gas = 0;
-    for ( int i = 0 ; i < 11 ; i++ ) {
-      if ( zt == zgases[i] ) gas = 1;
-    }
-
-    // Special case for gases
-    if ( gas ) {
-      gfact(&elog[0],zt,&ftargl);
-      dedxz2[0] += ftargl;
-      for ( int j = 1 ; j < 42 ; j++ ) {
-	gfact(&elog[j],zt,&ftarg);
-	dedxz2[j] += ftarg;
-      }
-    }
-    // It is a solid
-    else {
-      if ( zt != 13 ) {
-	mpyers(&elog[0],zt,&ftargl);
-	dedxz2[0] += ftargl;
-	for ( int j = 1 ; j < 42 ; j++ ) {
-	  mpyers(&elog[j],zt,&ftarg);
-	  dedxz2[j] += ftarg;
-	}
-      }
-    }
-    isw1 = true;
-  }
-  el = log10(e);
-  if ( el < elog[0] ) {
-    b = a + ak * el + ftargl;
-  }
-  else {
-    jj = nr_locate(elog,42,el);
-    if ( jj > 39 ) jj = 39;
-    b = nr_polint(&elog[jj],&dedxz2[jj],3,el,&err);
-  }
-  return pow(10.0,b);
-}
+static const double alog[42] = {
+  -1.903089986992,-1.795880017344,-1.698970004336,-1.602059991328,-1.494850021680,
+  -1.397940008672,-1.301029995664,-1.221848749616,-1.154901959986,-1.096910013008,
+  -1.045757490561,-1.000000000000,-0.903089986992,-0.795880017344,-0.698970004336,
+  -0.602059991328,-0.494850021680,-0.397940008672,-0.301029995664,-0.221848749616,
+  -0.154901959986,-0.096910013008,-0.045757490561,+0.000000000000,+0.096910013008,
+  +0.204119982656,+0.301029995664,+0.397940008672,+0.505149978320,+0.602059991328,
+  +0.698970004336,+0.778151250384,+0.845098040014,+0.903089986992,+0.954242509439,
+  +1.000000000000,+1.041392685158,+1.079181246048,+1.301029995664,+1.602059991328,
+  +1.845098040014,+2.000000000000};
 
 /*
-  Computes current value of nuclear stopping power for a
-  projectile of energy e (MeV/A), mass ap and charge zp in an
-  absorber with mass at and charge zt using a function fit to
-  the LSS universal nuclear stopping power curve.
+  Points of the s(2,a) function in log(E/A).
 */
-double ndedx(double e, int zp, int ap, int zt, int at) {
-
-  double zexpo, dedr;
-  double x, y, xl, yl;
-
-  // Compute current x-coordinate from projectile and target data
-  zexpo = sqrt(pow(zp,2.0/3.0) + pow(zt,2.0/3.0));
-  x = sqrt((e*ap*at/(ap+at)) / (zp*zt*zexpo));
-
-  // Get log for polynomial fit
-  xl = log10(x);
-  yl = -6.80959 + xl * 
-    (-6.60315 + xl * (-1.73474 + xl * xl * (0.04937 + xl * 0.00486)));
-  y = pow(10.0,yl);
-
-  // Convert y to -dEPS/dRHO
-  dedr = y * zt * ap / (zp * at * (ap+at) * zexpo);
-  return dedr;
-}
+static double s2el[38] = {
+  0.916290731874,1.098612288668,1.252762968495,1.386294361120,1.504077396776,1.609437912434,
+  1.704748092238,1.791759469228,1.871802176902,1.945910149055,2.079441541680,2.197224577336,
+  2.302585092994,2.397895272798,2.484906649788,2.708050201102,2.995732273554,3.218875824868,
+  3.401197381662,3.555348061489,3.688879454114,3.806662489770,3.912023005428,4.007333185232,
+  4.094344562222,4.174387269896,4.248495242049,4.382026634674,4.499809670330,4.605170185988,
+  5.010635294096,5.298317366548,5.521460917862,5.703782474656,5.857933154483,5.991464547108,
+  6.109247582764,6.214608098422};
 
 /*
-  Interpolate for current value of s(2,a) function as given by
-  F.Hubert, R.Rimbot and H.Gauvin, Atomic Data and Nuclear Data
-  Tables, 46, 1990.
+  Interpolate the -log(s(2,a)) function as given by F.Hubert,
+  R.Rimbot and H.Gauvin, Atomic Data and Nuclear Data Tables, 46, 1990,
+  at absorber charge zt on all the points s2el, and spline it in
+  log(E/A). This is the part of the two dimensional interpolation that
+  depends only on the absorber.
 */
-double s2az(double e, int zt) {
+static void s2az_row(int zt, double *y, double *y2) {
 
   double za[18] = {4.0,6.0,13.0,14.0,22.0,26.0,28.0,29.0,32.0,34.0,40.0,
 		   47.0,50.0,64.0,73.0,79.0,82.0,92.0};
 
-  double el[38] = {0.916290731874,1.098612288668,1.252762968495,1.386294361120,1.504077396776,1.609437912434,
-                   1.704748092238,1.791759469228,1.871802176902,1.945910149055,2.079441541680,2.197224577336,
-		   2.302585092994,2.397895272798,2.484906649788,2.708050201102,2.995732273554,3.218875824868,
-		   3.401197381662,3.555348061489,3.688879454114,3.806662489770,3.912023005428,4.007333185232,
-		   4.094344562222,4.174387269896,4.248495242049,4.382026634674,4.499809670330,4.605170185988,
-		   5.010635294096,5.298317366548,5.521460917862,5.703782474656,5.857933154483,5.991464547108,
-		   6.109247582764,6.214608098422};
-
-  double sa2[18][38] = {
+  static double sa2[18][38] = {
     {2.19060,2.32662,2.44357,2.54625,2.63806,2.72038,2.79565,2.86470,2.92901,
      2.98826,3.09555,3.19114,3.27677,3.35455,3.42575,3.60822,3.84436,4.02575,
      4.17501,4.29953,4.40693,4.50104,4.58488,4.66015,4.72819,4.79060,4.84820,
@@ -950,100 +886,156 @@ double s2az(double e, int zt) {
 
   static double y2a[18][38];
   static double *psa2[18], *py2a[18];
-  double sa2ln;
-  double le;
+  double ytmp[18], y2tmp[18];
 
   if ( !isw5 ) {
     for ( int i = 0 ; i < 18 ; i++ ) {
       psa2[i] = &(sa2[i])[0];
       py2a[i] = &(y2a[i])[0];
     }
-    nr_splie2(el,za,&psa2[0],38,18,&py2a[0]);
+    nr_splie2(s2el,za,&psa2[0],38,18,&py2a[0]);
     isw5 = true;
   }
-  le = log(e);
-  nr_splin2(el,za,&psa2[0],&py2a[0],38,18,le,zt,&sa2ln);
-  return exp(-sa2ln);
+  for ( int j = 0 ; j < 38 ; j++ ) {
+    for ( int i = 0 ; i < 18 ; i++ ) {
+      ytmp[i] = sa2[i][j];
+      y2tmp[i] = y2a[i][j];
+    }
+    nr_splint(za,ytmp,y2tmp,18,zt,&y[j]);
+  }
+  nr_spline(s2el,y,38,1.0e30,1.0e30,y2);
 }
 
 /*
-  Compute the "electrical" energy loss rate in any material
-  (-dE/dx) above 2.5 MeV/A according to Hubert et al.
+  Stopping power data of absorber elements and projectiles, calculated
+  once per charge and kept for the life of the program. The absorber
+  data are the conversion from aluminium (gfact() or mpyers()) at the
+  points of the data pool, the s(2,a) spline and the H-B-G
+  coefficients; the projectile data are the stopping powers in
+  aluminium (alion()). Must be called with the library lock held.
 */
-double ededxh(double ea, int zp, int zt) {
+static struct rside side[ZMAX+1];
+static struct rproj proj[ZMAX+1];
+static atomic_int side_ok[ZMAX+1], proj_ok[ZMAX+1];
 
-  static double b, c, d;
-  static double x1, x2, x3, x4;
-  double xg1;
+const struct rside *rside_get(int zt) {
 
-  // Special case for He
-  if ( zp == 2 ) {
-    isw2 = true;
-    return s2az(ea,zt)*4.0;
-  }
-
-  if ( !isw2 ) {
-    if ( zt == 4 ) {
-      b = 2.000;
-      c = 0.04369;
-      d = 2.045;
-      x2 = 7.000;
-      x3 = 0.2643;
-      x4 = 0.4171;
-    }
-    else if ( zt == 6 ) {
-      b = 1.910;
-      c = 0.03958;
-      d = 2.584;
-      x2 = 6.933;
-      x3 = 0.2433;
-      x4 = 0.3969;
+  int zgases[11] = {1,2,7,8,9,10,17,18,36,54,86};
+  struct rside *s;
+  int gas;
+
+  if ( zt < 1 || zt > ZMAX ) {
+    fprintf(stderr,"No valid absorber charge %d.\n",zt);
+    exit(EXIT_FAILURE);
+  }
+  s = &side[zt];
+  if ( atomic_load_explicit(&side_ok[zt],memory_order_acquire) ) return s;
+
+  // Elements of the table pack are linked in
+  const struct rside *ps = rtab_pack_side(zt);
+  if ( ps != NULL ) {
+    *s = *ps;
+    atomic_store_explicit(&side_ok[zt],1,memory_order_release);
+    return s;
+  }
+
+  TRACE_BEGIN(t0);
+
+  s->zt = zt;
+  for ( int j = 0 ; j < 42 ; j++ ) {
+    s->elog[j] = alog[j];
+    s->ftarg[j] = 0.0;
+  }
+
+  // Is it a gas?
+  gas = 0;
+  for ( int i = 0 ; i < 11 ; i++ ) {
+    if ( zt == zgases[i] ) gas = 1;
+  }
+
+  // Special case for gases
+  TRACE_BEGIN(t1);
+  if ( gas ) {
+    for ( int j = 0 ; j < 42 ; j++ ) {
+      gfact(&s->elog[j],zt,&s->ftarg[j]);
     }
-    else {
-      b = 1.658;
-      c = 0.0517;
-      d = 1.164 + 0.2319 * exp(-0.004302*zt);
-      x2 = 8.144 + 0.09876 * log(zt);
-      x3 = 0.314 + 0.01072 * log(zt);
-      x4 = 0.5218 + 0.02521 * log(zt);
+    TRACE_END(t1,"gfact","\"zt\":%d",zt);
+  }
+  // It is a solid
+  else {
+    if ( zt != 13 ) {
+      for ( int j = 0 ; j < 42 ; j++ ) {
+	mpyers(&s->elog[j],zt,&s->ftarg[j]);
+      }
+      TRACE_END(t1,"mpyers","\"zt\":%d",zt);
     }
-    x1 = d + b * exp(-c*zp);
-    isw2 = true;
   }
-  xg1 = 1.0 - x1 * exp(-x2*pow(ea,x3)/pow(zp,x4));
-  return s2az(ea,zt)*pow((xg1*zp),2);
+
+  TRACE_BEGIN(t2);
+  s2az_row(zt,s->s2,s->s2y2);
+  TRACE_END(t2,"s2az_row","\"zt\":%d",zt);
+
+  // H-B-G coefficients
+  if ( zt == 4 ) {
+    s->b = 2.000;
+    s->c = 0.04369;
+    s->d = 2.045;
+    s->x2 = 7.000;
+    s->x3 = 0.2643;
+    s->x4 = 0.4171;
+  }
+  else if ( zt == 6 ) {
+    s->b = 1.910;
+    s->c = 0.03958;
+    s->d = 2.584;
+    s->x2 = 6.933;
+    s->x3 = 0.2433;
+    s->x4 = 0.3969;
+  }
+  else {
+    s->b = 1.658;
+    s->c = 0.0517;
+    s->d = 1.164 + 0.2319 * exp(-0.004302*zt);
+    s->x2 = 8.144 + 0.09876 * log(zt);
+    s->x3 = 0.314 + 0.01072 * log(zt);
+    s->x4 = 0.5218 + 0.02521 * log(zt);
+  }
+
+  atomic_store_explicit(&side_ok[zt],1,memory_order_release);
+  TRACE_END(t0,"rside_get","\"zt\":%d",zt);
+  return s;
 }
 
-/*
-  Compute 1/(dE/dx) for a given energy E/A and projectile and target.
-*/
-double dedx(int icorr, double ea, int zp, int ap, int zt, int at) {
+const struct rproj *rproj_get(int zp) {
 
-  double dedxn, dedxe;
+  struct rproj *p;
 
-  if ( ea < 2.5 ) icorr = 0;
-  switch(icorr) {
-  case 0:
-    dedxn = ndedx(ea,zp,ap,zt,at);
-    dedxe = ededx(ea,zp,zt);
-    return (dedxn + dedxe)*pow(zp,2);
-    break;
-  case 1:
-    return ededxh(ea,zp,zt);
-    break;
-  default:
-    fprintf(stderr,"No valid range correlation.\n");
+  if ( zp < 1 || zp > ZMAX ) {
+    fprintf(stderr,"No valid projectile charge %d.\n",zp);
     exit(EXIT_FAILURE);
   }
+  p = &proj[zp];
+  if ( atomic_load_explicit(&proj_ok[zp],memory_order_acquire) ) return p;
+  const struct rproj *pp = rtab_pack_proj(zp);
+  if ( pp != NULL ) {
+    *p = *pp;
+    atomic_store_explicit(&proj_ok[zp],1,memory_order_release);
+    return p;
+  }
+  TRACE_BEGIN(t0);
+  p->zp = zp;
+  alion(zp,&p->dedxz2[0]);
+  atomic_store_explicit(&proj_ok[zp],1,memory_order_release);
+  TRACE_END(t0,"alion","\"zp\":%d",zp);
+  return p;
 }
 
 /*
-  Calculates a range table given projectile and absorber. Tables are
-  saved in stack to speed up calculations. Up to NSAV such tables 
-  are saved.
+  Fill grid with the energy grid of the tables of correlation icorr, in
+  log10(E/A), and return its number of points. The N-S grid is the
+  start of the H-B-G grid.
 */
-void rangetab(int icorr, int zp, int ap, int iabso, int zt, int at,
-	      double *em, double *r, int *n){
+static int rtab_grid(int icorr, double *grid) {
 
   double elog[62] = {
     -2.0000000000,-1.9030899870,-1.7958800173,-1.6989700043,-1.6020599913,
@@ -1062,59 +1054,17 @@ void rangetab(int icorr, int zp, int ap, int iabso, int zt, int at,
 
   const double fmt = 0.005;
   int ntalel;
-  double wtot;
-
-  double est, elg, e;
-  double rng, rval, rnow, rold;
-  double etot, eold;
-  double dedxnow;
-
-  int k;
-  int jsav;
-  static int isav = 0;
-  static int icc[NSAV], ijj[NSAV], iab[NSAV];
-  static int izp[NSAV], iap[NSAV], izt[NSAV], iat[NSAV];
-  static double esav[NSAV][NMAX], rsav[NSAV][NMAX];
-
-  // Check if table saved
-  if ( isav > 0 ) {
-    for ( int i = 0 ; i < isav ; i++ ) {
-      jsav = 0;
-      if ( icorr == icc[i] ) jsav++;
-      if ( iabso == iab[i] ) jsav++;
-      if ( zp == izp[i] ) jsav++;
-      if ( ap == iap[i] ) jsav++;
-      if ( zt == izt[i] ) jsav++;
-      if ( at == iat[i] ) jsav++;
-      if ( jsav == 6 ) {
-	k = ijj[i];
-	for ( int j = 0 ; j < k ; j++ ) {
-	  *(em+j) = esav[i][j];
-	  *(r+j) = rsav[i][j];
-	}
-	*n = k;
-	return;
-      }
-    }
-  }
 
-  if ( isav > NSAV ) {
-    fprintf(stderr,"WARNING in rangetab: NSAV is too small\n");
-    exit(EXIT_FAILURE);
-  }
-  // Save this call
-  icc[isav] = icorr;
-  iab[isav] = iabso;
-  izp[isav] = zp;
-  iap[isav] = ap;
-  izt[isav] = zt;
-  iat[isav] = at;
+  double est, elg;
+
+  int n;
 
   switch(icorr) {
   case 0:
     ntalel = 38;
     break;
   case 1:
+  case 2:
     ntalel = 61;
     break;
   default:
@@ -1122,116 +1072,923 @@ void rangetab(int icorr, int zp, int ap, int iabso, int zt, int at,
     exit(EXIT_FAILURE);
   }
 
-  // allocate matrix
-  double **dedxt = malloc(NELMAX*sizeof(double *));
-  for ( int i = 0 ; i < NELMAX ; i++ ) {
-    dedxt[i] = malloc(NMAX*sizeof(double));
+  // The energy grid is the same for all elements of the absorber
+  est = 0.9 * elog[0];
+  n = 0;
+  for ( int j = 1 ; j <= 7000 ; j++ ) {
+    elg = fmt * (double)(j-1200);
+    if ( elg >= est ) {
+      if ( elg <= elog[ntalel] ) {
+	grid[n++] = elg;
+      }
+      else {
+	break;
+      }
+      if ( n > 3999 ) break;
+    }
   }
+  return n;
+}
 
-  // define absorber
-  def_absorber(zt,at,iabso);
+/*
+  Absorber and projectile data at the points of the H-B-G energy grid,
+  which holds those of the N-S grid: the target factor and exp(-s(2,a))
+  of each element, and log10((-dE/dx)/Z2) in aluminium of each
+  projectile, interpolated as in ededx_lg() and ededxh_v(). Calculated
+  once per charge, with the library lock held, so that the tables of
+  many projectiles in one absorber do not interpolate them again.
+*/
+static double *side_f[ZMAX+1], *side_h[ZMAX+1], *proj_g[ZMAX+1];
 
-  // Compute a range table
-  est = 0.9 * elog[0];
-  wtot = 0.0;
-  for ( int i = 0 ; i < numel ; i++ ) {
-    isw1 = false;
-    isw2 = false;
-    zt = cmpnd[i].z;
-    at = cmpnd[i].a;
-    wtot += cmpnd[i].w;
-    *n = 0;
-    for ( int j = 1 ; j <= 7000 ; j++ ) {
-      elg = fmt * (double)(j-1200);
-      e = pow(exp(elg),log(10.0));
-      if ( elg >= est ) {
-	if ( elg <= elog[ntalel] ) {
-	  dedxt[i][*n] = dedx(icorr,e,zp,ap,zt,at);
-	  *(em+(*n)) = elg;
-	  (*n)++;
-	}
-	else {
-	  break;
-	}
-	if ( *n > 3999 ) break;
+static void side_grid(const struct rside *s) {
+
+  double grid[NMAX], err, *f, *h;
+  int n;
+
+  if ( side_f[s->zt] != NULL ) return;
+  n = rtab_grid(1,grid);
+  if ( (f = malloc(2*n*sizeof(double))) == NULL ) {
+    fprintf(stderr,"rangetab: out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  h = f + n;
+  for ( int j = 0 ; j < n ; j++ ) {
+    if ( grid[j] < s->elog[0] ) {
+      f[j] = s->ftarg[0];
+    }
+    else {
+      unsigned int jj = nr_locate((double *)s->elog,42,grid[j]);
+      if ( jj > 39 ) jj = 39;
+      f[j] = nr_polint((double *)&s->elog[jj],(double *)&s->ftarg[jj],3,grid[j],&err);
+    }
+    nr_splint(s2el,(double *)s->s2,(double *)s->s2y2,38,grid[j]*log(10.0),&h[j]);
+    h[j] = -h[j];
+  }
+  vexp(h,h,n);
+  side_f[s->zt] = f;
+  side_h[s->zt] = h;
+}
+
+static void proj_grid(const struct rproj *pp) {
+
+  double grid[NMAX], err, ak, a, *g;
+  int n;
+
+  if ( proj_g[pp->zp] != NULL ) return;
+  n = rtab_grid(1,grid);
+  if ( (g = malloc(n*sizeof(double))) == NULL ) {
+    fprintf(stderr,"rangetab: out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  ak = (pp->dedxz2[2] - pp->dedxz2[0]) / (alog[2] - alog[0]);
+  a = pp->dedxz2[0] - ak * alog[0];
+  for ( int j = 0 ; j < n ; j++ ) {
+    if ( grid[j] < alog[0] ) {
+      g[j] = a + ak * grid[j];
+    }
+    else {
+      unsigned int jj = nr_locate((double *)alog,42,grid[j]);
+      if ( jj > 39 ) jj = 39;
+      g[j] = nr_polint((double *)&alog[jj],(double *)&pp->dedxz2[jj],3,grid[j],&err);
+    }
+  }
+  proj_g[pp->zp] = g;
+}
+
+/*
+  Fill the stopping power data of one projectile in one absorber
+  element from the projectile and absorber data.
+*/
+static void pair_init(struct pair *p, const struct rproj *pp, int ap,
+		      const struct rside *s, int at) {
+  p->zp = pp->zp;
+  p->ap = ap;
+  p->zt = s->zt;
+  p->at = at;
+  p->s = s;
+  p->ak = (pp->dedxz2[2] - pp->dedxz2[0]) / (alog[2] - alog[0]);
+  p->a = pp->dedxz2[0] - p->ak * alog[0];
+  for ( int j = 0 ; j < 42 ; j++ ) {
+    p->dedxz2[j] = pp->dedxz2[j] + s->ftarg[j];
+  }
+  p->x1 = s->d + s->b * exp(-s->c*p->zp);
+  p->zx4 = pow(p->zp,s->x4);
+  p->gf = p->gh = p->gp = NULL;
+}
+
+/*
+  Compute log10 of the "electrical" energy loss rate in any material
+  (-dE/dx)/Z2, at el = log10(E/A).
+*/
+static double ededx_lg(const struct pair *p, double el) {
+
+  unsigned int jj;
+  double err;
+
+  if ( el < p->s->elog[0] ) {
+    return p->a + p->ak * el + p->s->ftarg[0];
+  }
+  jj = nr_locate((double *)p->s->elog,42,el);
+  if ( jj > 39 ) jj = 39;
+  return nr_polint((double *)&p->s->elog[jj],(double *)&p->dedxz2[jj],3,el,&err);
+}
+
+/*
+  Computes log10 of the nuclear stopping power at the m energies
+  el = log10(E/A) using a function fit to the LSS universal nuclear
+  stopping power curve. The logarithms of the energy scale and of the
+  conversion to -dEPS/dRHO are calculated once.
+*/
+static void ndedx_v(const struct pair *p, const double *el, int m, double *yl) {
+
+  int zp = p->zp, ap = p->ap, zt = p->zt, at = p->at;
+  double zexpo, xl0, yl0, xl;
+
+  // Compute x-coordinate scale from projectile and target data
+  zexpo = sqrt(pow(zp,2.0/3.0) + pow(zt,2.0/3.0));
+  xl0 = log10(((double)ap*at/(ap+at)) / (zp*zt*zexpo));
+
+  // Convert y to -dEPS/dRHO
+  yl0 = log10(zt * ap / (zp * at * (ap+at) * zexpo));
+
+  for ( int j = 0 ; j < m ; j++ ) {
+    // Get log for polynomial fit
+    xl = 0.5 * (el[j] + xl0);
+    yl[j] = yl0 - 6.80959 + xl *
+      (-6.60315 + xl * (-1.73474 + xl * xl * (0.04937 + xl * 0.00486)));
+  }
+}
+
+/*
+  Compute the "electrical" energy loss rate in any material
+  (-dE/dx) above 2.5 MeV/A according to Hubert et al., at the m <= NBLK
+  energies el = log10(E/A). If hs is not NULL it holds s(2,a) at el.
+*/
+static void ededxh_v(const struct pair *p, const double *el, const double *hs,
+		     int m, double *s) {
+
+  const struct rside *r = p->s;
+  double u[NBLK], v[NBLK];
+  int zp = p->zp;
+
+  if ( hs != NULL ) {
+    for ( int j = 0 ; j < m ; j++ ) {
+      s[j] = hs[j];
+    }
+  }
+  else {
+    for ( int j = 0 ; j < m ; j++ ) {
+      nr_splint(s2el,(double *)r->s2,(double *)r->s2y2,38,el[j]*log(10.0),&s[j]);
+      s[j] = -s[j];
+    }
+    vexp(s,s,m);
+  }
+
+  // Special case for He
+  if ( zp == 2 ) {
+    for ( int j = 0 ; j < m ; j++ ) {
+      s[j] *= 4.0;
+    }
+    return;
+  }
+
+  // pow(ea,x3)
+  for ( int j = 0 ; j < m ; j++ ) {
+    u[j] = r->x3 * el[j];
+  }
+  vexp10(u,v,m);
+  for ( int j = 0 ; j < m ; j++ ) {
+    u[j] = -r->x2 * v[j] / p->zx4;
+  }
+  vexp(u,v,m);
+  for ( int j = 0 ; j < m ; j++ ) {
+    double xg1 = 1.0 - p->x1 * v[j];
+    s[j] *= (xg1*zp) * (xg1*zp);
+  }
+}
+
+/*
+  Weight of the Hubert-Bimbot-Gauvin correlations in the blended
+  stopping power (icorr = 2), at el = log10(E/A). The weight rises
+  smoothly in log(E/A) from 0 at 2.5 MeV/A to 1 at 12 MeV/A, where the
+  two correlations overlap.
+*/
+static double blend(double el) {
+  double x;
+  if ( el <= LG25 ) return 0.0;
+  if ( el >= LG12 ) return 1.0;
+  x = (el - LG25) / (LG12 - LG25);
+  return x * x * (3.0 - 2.0 * x);
+}
+
+/*
+  Weight of the H-B-G correlations at el = log10(E/A) for icorr.
+*/
+static double corr_w(int icorr, double el) {
+  switch(icorr) {
+  case 0:
+    return 0.0;
+  case 1:
+    return el < LG25 ? 0.0 : 1.0;
+  case 2:
+    return blend(el);
+  default:
+    fprintf(stderr,"No valid range correlation.\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+/*
+  Compute dE/dx, electronic in se[] and nuclear in sn[], at the m <=
+  NBLK energies el = log10(E/A). Below 2.5 MeV/A the N-S correlations
+  are used whatever icorr. The points of each correlation are
+  gathered, so that the powers and exponentials are calculated an
+  array at a time. If g is not negative, el are the points from g of
+  the energy grid, and the grid data of p are used if it has them.
+*/
+static void dedx_v(int icorr, const struct pair *p, const double *el, int g, int m,
+		   double *se, double *sn) {
+
+  int grid = g >= 0 && p->gf != NULL;
+  double lns[NBLK], lhb[NBLK], y1[NBLK], y2[NBLK], w[NBLK], hs[NBLK];
+  int ins[NBLK], ihb[NBLK];
+  int nns = 0, nhb = 0;
+  int z2 = p->zp * p->zp;
+
+  for ( int j = 0 ; j < m ; j++ ) {
+    w[j] = corr_w(icorr,el[j]);
+    if ( w[j] < 1.0 ) {
+      ins[nns] = j;
+      lns[nns++] = el[j];
+    }
+    if ( w[j] > 0.0 ) {
+      ihb[nhb] = j;
+      lhb[nhb++] = el[j];
+    }
+  }
+
+  if ( nns > 0 ) {
+    for ( int k = 0 ; k < nns ; k++ ) {
+      y1[k] = grid ? p->gp[g+ins[k]] + p->gf[g+ins[k]] : ededx_lg(p,lns[k]);
+    }
+    ndedx_v(p,lns,nns,y2);
+    vexp10(y1,y1,nns);
+    vexp10(y2,y2,nns);
+    for ( int k = 0 ; k < nns ; k++ ) {
+      se[ins[k]] = y1[k] * z2;
+      sn[ins[k]] = y2[k] * z2;
+    }
+  }
+  if ( nhb > 0 ) {
+    for ( int k = 0 ; grid && k < nhb ; k++ ) {
+      hs[k] = p->gh[g+ihb[k]];
+    }
+    ededxh_v(p,lhb,grid ? hs : NULL,nhb,y1);
+    for ( int k = 0 ; k < nhb ; k++ ) {
+      int j = ihb[k];
+      if ( w[j] == 1.0 ) {
+	se[j] = y1[k];
+	sn[j] = 0.0;
+      }
+      else {
+	se[j] = (1.0 - w[j]) * se[j] + w[j] * y1[k];
+	sn[j] = (1.0 - w[j]) * sn[j];
       }
     }
   }
+}
 
-  ijj[isav] = *n;
+/*
+  The nuclear dE/dx of dedx_v() alone, at the m <= NBLK energies el.
+*/
+static void sndx_v(int icorr, const struct pair *p, const double *el, int m,
+		   double *sn) {
+  int z2 = p->zp * p->zp;
+  ndedx_v(p,el,m,sn);
+  vexp10(sn,sn,m);
+  for ( int j = 0 ; j < m ; j++ ) {
+    sn[j] = (1.0 - corr_w(icorr,el[j])) * (sn[j] * z2);
+  }
+}
 
-  rng = 0.0;
-  rold = 0.0;
-  eold = 0.0;
-  for ( int j = 0 ; j < *n ; j++ ) {
-    elg = *(em+j);
-    e = pow(exp(elg),log(10.0));
-    etot = e * ap;
-    dedxnow = 0.0;
-    for ( int i = 0 ; i < numel ; i++ ) {
-      dedxnow += dedxt[i][j] * cmpnd[i].w;
+/*
+  Electronic, nuclear and H-B-G stopping powers of a projectile of
+  energy e (MeV/A) in one element. These are kept for programs that
+  call them, and take the library lock.
+*/
+double ededx(double e, int zp, int zt) {
+  struct pair p;
+  range_lock();
+  pair_init(&p,rproj_get(zp),1,rside_get(zt),1);
+  range_unlock();
+  return pow(10.0,ededx_lg(&p,log10(e)));
+}
+
+double ndedx(double e, int zp, int ap, int zt, int at) {
+  struct pair p;
+  double el = log10(e), yl;
+  range_lock();
+  pair_init(&p,rproj_get(zp),ap,rside_get(zt),at);
+  range_unlock();
+  ndedx_v(&p,&el,1,&yl);
+  return pow(10.0,yl);
+}
+
+double s2az(double e, int zt) {
+  const struct rside *s;
+  double y;
+  range_lock();
+  s = rside_get(zt);
+  range_unlock();
+  nr_splint(s2el,(double *)s->s2,(double *)s->s2y2,38,log(e),&y);
+  return exp(-y);
+}
+
+double ededxh(double ea, int zp, int zt) {
+  struct pair p;
+  double el = log10(ea), s;
+  range_lock();
+  pair_init(&p,rproj_get(zp),1,rside_get(zt),1);
+  range_unlock();
+  ededxh_v(&p,&el,NULL,1,&s);
+  return s;
+}
+
+/*
+  Compute dE/dx for a given energy E/A and projectile and target.
+*/
+double dedx(int icorr, double ea, int zp, int ap, int zt, int at) {
+  struct pair p;
+  double el = log10(ea), se, sn;
+  range_lock();
+  pair_init(&p,rproj_get(zp),ap,rside_get(zt),at);
+  range_unlock();
+  dedx_v(icorr,&p,&el,-1,1,&se,&sn);
+  return se + sn;
+}
+
+static atomic_int lazy = 0;
+
+/*
+  Select lazy range tables. A lazy table is published with only the
+  range at the first point of each segment, obtained by Gauss-Legendre
+  quadrature, and the segments are integrated on first use.
+*/
+void range_lazy(int on) {
+  atomic_store(&lazy,on != 0);
+}
+
+int rtab_lazy(void) {
+  return atomic_load(&lazy);
+}
+
+static atomic_int scaling = 0;
+
+/*
+  Select velocity scaling of range tables across isotopes. With mode
+  RANGE_SCALE_NUCLEAR or RANGE_SCALE_ELECTRONIC, the table of an ion
+  not in the cache is built from the electronic stopping power of its
+  element in the absorber, calculated once per element, adding the
+  nuclear stopping power of the isotope with the former, and ignoring
+  it with the latter. Mode 0 builds every table in full.
+*/
+void range_scaling(int mode) {
+  if ( mode < 0 || mode > RANGE_SCALE_ELECTRONIC ) {
+    fprintf(stderr,"range_scaling: invalid mode %d\n",mode);
+    exit(EXIT_FAILURE);
+  }
+  atomic_store(&scaling,mode);
+}
+
+int rtab_scaling(void) {
+  return atomic_load(&scaling);
+}
+
+/*
+  Compute the stopping power of the absorber of table t at the m
+  energies el = log10(E/A), averaged over the elements by mass weight.
+  g is the index of el[0] in the table points, or -1 if el are not
+  table points.
+*/
+static void rtab_dedx(const struct rtab *t, const double *el, int g, int m, double *s) {
+
+  double wtot = 0.0, se[NBLK], sn[NBLK];
+
+  for ( int j = 0 ; j < m ; j++ ) {
+    s[j] = 0.0;
+  }
+  for ( int i = 0 ; i < t->numel ; i++ ) {
+    wtot += t->cmp[i].w;
+    for ( int j0 = 0 ; j0 < m ; j0 += NBLK ) {
+      int mb = m - j0 < NBLK ? m - j0 : NBLK;
+      dedx_v(t->icorr,&t->pair[i],&el[j0],g < 0 ? -1 : g+j0,mb,se,sn);
+      for ( int j = 0 ; j < mb ; j++ ) {
+	s[j0+j] += (se[j] + sn[j]) * t->cmp[i].w;
+      }
     }
-    dedxnow /= wtot;
-    rnow = 1.0 / dedxnow;
-    rval = 0.5 * (rold + rnow) * (etot - eold);
+  }
+  for ( int j = 0 ; j < m ; j++ ) {
+    s[j] /= wtot;
+  }
+}
+
+// The composition and stopping power data of a header, with its key
+static void head_cmp(struct rtab *h, int icorr, int zp, int ap,
+		     const struct elem *cmp, int n) {
+  h->icorr = icorr;
+  h->zp = zp;
+  h->ap = ap;
+  h->iabso = -1;
+  h->zt = 0;
+  h->at = 0;
+  h->numel = n;
+  for ( int i = 0 ; i < n ; i++ ) {
+    h->cmp[i] = cmp[i];
+    pair_init(&h->pair[i],rproj_get(zp),ap,rside_get(cmp[i].z),cmp[i].a);
+  }
+}
+
+// The data on the energy grid of the elements and projectile of a header
+static void head_grid(struct rtab *h) {
+  proj_grid(rproj_get(h->zp));
+  for ( int i = 0 ; i < h->numel ; i++ ) {
+    int z = h->cmp[i].z;
+    side_grid(h->pair[i].s);
+    h->pair[i].gf = side_f[z];
+    h->pair[i].gh = side_h[z];
+    h->pair[i].gp = proj_g[h->zp];
+  }
+}
+
+/*
+  Fill the key, the absorber composition and the stopping power data of
+  a table header for rtab_make(). Tables of the table pack integrate
+  only the segments used, point by point, so their headers go without
+  the data on the energy grid. Must be called with the library lock
+  held.
+*/
+void rtab_head(struct rtab *h, int icorr, int zp, int ap, int iabso, int zt, int at) {
+  TRACE_BEGIN(t0);
+  def_absorber(zt,at,iabso);
+  head_cmp(h,icorr,zp,ap,cmpnd,numel);
+  h->iabso = iabso;
+  h->zt = zt;
+  h->at = at;
+  if ( rtab_pack_find(icorr,zp,ap,iabso,zt,at) == NULL ) head_grid(h);
+  TRACE_END(t0,"rtab_head","\"zp\":%d,\"iabso\":%d,\"zt\":%d",zp,iabso,zt);
+}
+
+/*
+  As rtab_head() for an absorber of n elements given in cmp. The key is
+  that of a user defined compound.
+*/
+void rtab_head_cmp(struct rtab *h, int icorr, int zp, int ap,
+		   const struct elem *cmp, int n) {
+  head_cmp(h,icorr,zp,ap,cmp,n);
+  head_grid(h);
+}
+
+/*
+  Allocate a table for the header h, in one block so that it can be
+  saved in the table cache (rangecache.c) and freed with a single call,
+  and fill its key, composition and energy grid. If el is not 0 the
+  block holds the electronic stopping power at the table points.
+*/
+static struct rtab *rtab_alloc(const struct rtab *h, int el) {
+
+  int n, nseg;
+  double grid[NMAX];
+  struct rtab *t;
+
+  n = rtab_grid(h->icorr,grid);
+  nseg = (n + NSEG - 1) / NSEG;
+
+  t = malloc(sizeof(struct rtab) + ((el ? 3 : 2)*n+nseg)*sizeof(double) +
+	     nseg*(sizeof(atomic_ulong)+sizeof(atomic_int)));
+  if ( t == NULL ) {
+    fprintf(stderr,"rangetab: out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  t->icorr = h->icorr;
+  t->zp = h->zp;
+  t->ap = h->ap;
+  t->iabso = h->iabso;
+  t->zt = h->zt;
+  t->at = h->at;
+  t->seq = 0;
+  t->n = n;
+  t->nseg = nseg;
+  t->em = (double *)(t+1);
+  t->r = t->em + n;
+  t->roff = t->r + n;
+  t->se = el ? t->roff + nseg : NULL;
+  t->hits = (atomic_ulong *)(t->roff + nseg + (el ? n : 0));
+  t->built = (atomic_int *)(t->hits + nseg);
+  for ( int k = 0 ; k < nseg ; k++ ) {
+    atomic_init(&t->hits[k],0);
+  }
+  for ( int k = 0 ; k < RANGE_NERR ; k++ ) {
+    atomic_init(&t->herr[k],0);
+  }
+  atomic_init(&t->ref,0);
+  t->priv = 0;
+
+  t->numel = h->numel;
+  for ( int i = 0 ; i < h->numel ; i++ ) {
+    t->cmp[i] = h->cmp[i];
+    t->pair[i] = h->pair[i];
+  }
+
+  for ( int j = 0 ; j < n ; j++ ) {
+    t->em[j] = grid[j];
+  }
+
+  return t;
+}
+
+// Mark a table whose ranges are all filled in as complete
+static void rtab_done(struct rtab *t) {
+  for ( int k = 0 ; k < t->nseg ; k++ ) {
+    t->roff[k] = t->r[k*NSEG];
+    atomic_init(&t->built[k],1);
+  }
+  atomic_init(&t->complete,1);
+}
+
+/*
+  Integrate the complete range table of ap nucleons from the stopping
+  power s at the table points.
+*/
+static void rtab_integrate(struct rtab *t, int ap, const double *s) {
+
+  double rng = 0.0, rold = 0.0, eold = 0.0;
+  double *e = malloc(t->n*sizeof(double));
+
+  if ( e == NULL ) {
+    fprintf(stderr,"rangetab: out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  vexp10(t->em,e,t->n);
+  for ( int j = 0 ; j < t->n ; j++ ) {
+    double etot = e[j] * ap;
+    double rnow = 1.0 / s[j];
+    double rval = 0.5 * (rold + rnow) * (etot - eold);
     rng += rval;
-    *(r+j) = rng;
+    t->r[j] = rng;
     eold = etot;
     rold = rnow;
-    esav[isav][j] = *(em+j);
-    rsav[isav][j] = *(r+j);
   }
-  isav++;
+  free(e);
+  rtab_done(t);
+}
+
+/*
+  Calculates a range table given the header filled by rtab_head(). The
+  table is allocated in one block so that it can be saved in the table
+  cache (rangecache.c) and freed with a single call. The stopping power
+  routines keep no state, so tables may be calculated without the
+  library lock and from several threads at once. If lz is not 0 only
+  the range at the first point of each segment is calculated. Tables
+  of the table pack (rangepack.c) are loaded from it, lazy whatever lz.
+*/
+struct rtab *rtab_make(const struct rtab *h, int lz) {
 
-  // free allocated memory
-  for ( int i = 0 ; i < NELMAX ; i++ ) {
-    free(dedxt[i]);
+  const struct rpack *pk = rtab_pack_find(h->icorr,h->zp,h->ap,h->iabso,h->zt,h->at);
+  if ( pk != NULL ) return rtab_load(h,pk->roff,pk->nseg);
+  return rtab_calc(h,lz);
+}
+
+/*
+  As rtab_make(), calculating the table even if it is in the table
+  pack.
+*/
+struct rtab *rtab_calc(const struct rtab *h, int lz) {
+
+  // 4-point Gauss-Legendre abscissas and weights
+  const double xg[4] = {-0.8611363115940526,-0.3399810435848563,
+			 0.3399810435848563, 0.8611363115940526};
+  const double wg[4] = {0.3478548451374538,0.6521451548625461,
+			0.6521451548625461,0.3478548451374538};
+
+  TRACE_BEGIN(t0);
+  struct rtab *t = rtab_alloc(h,0);
+  int nseg = t->nseg, ap = t->ap;
+  double rval;
+
+  if ( !lz ) {
+
+    // Compute a range table
+    double *s = malloc(t->n*sizeof(double));
+    if ( s == NULL ) {
+      fprintf(stderr,"rangetab: out of memory\n");
+      exit(EXIT_FAILURE);
+    }
+    rtab_dedx(t,t->em,0,t->n,s);
+    rtab_integrate(t,ap,s);
+    free(s);
   }
-  free(dedxt);
+  else {
 
+    /*
+      Range at the first point of each segment. Each segment is split in
+      two halves integrated with 4 points each. The H-B-G correlations
+      switch to N-S below 2.5 MeV/A, where the stopping power jumps, and
+      the segment holding the switch is integrated with the trapezoidal
+      rule on its points instead, as the complete table is, so that both
+      tables cross the jump alike.
+    */
+    const double xs = log10(2.5);
+    int m = 1 + 8*(nseg-1), ks = -1;
+    double *lg = malloc(m*sizeof(double));
+    double *eg = malloc(m*sizeof(double));
+    double *sg = malloc(m*sizeof(double));
+    double *hg = malloc((2*nseg+2*(NSEG+1))*sizeof(double));
+    if ( lg == NULL || eg == NULL || sg == NULL || hg == NULL ) {
+      fprintf(stderr,"rangetab: out of memory\n");
+      exit(EXIT_FAILURE);
+    }
+    lg[0] = t->em[0];
+    for ( int k = 0 ; k < nseg-1 ; k++ ) {
+      double a = t->em[k*NSEG], b = t->em[(k+1)*NSEG];
+      double c = 0.5 * (a + b);
+      if ( t->icorr == 1 && a < xs && xs < b ) ks = k;
+      hg[2*k] = c - a;
+      hg[2*k+1] = b - c;
+      for ( int g = 0 ; g < 4 ; g++ ) {
+	lg[1+8*k+g] = 0.5 * (a + c) + 0.5 * (c - a) * xg[g];
+	lg[5+8*k+g] = 0.5 * (c + b) + 0.5 * (b - c) * xg[g];
+      }
+    }
+    vexp10(lg,eg,m);
+    rtab_dedx(t,lg,-1,m,sg);
+
+    t->roff[0] = 0.5 * (1.0 / sg[0]) * eg[0] * ap;
+    for ( int k = 0 ; k < nseg-1 ; k++ ) {
+      rval = 0.0;
+      if ( k == ks ) {
+	double *e = &hg[2*nseg], *s = e + NSEG + 1;
+	vexp10(&t->em[k*NSEG],e,NSEG+1);
+	rtab_dedx(t,&t->em[k*NSEG],k*NSEG,NSEG+1,s);
+	for ( int j = 1 ; j <= NSEG ; j++ ) {
+	  rval += 0.5 * (1.0/s[j-1] + 1.0/s[j]) * (e[j] - e[j-1]) * ap;
+	}
+	t->roff[k+1] = t->roff[k] + rval;
+	continue;
+      }
+      for ( int g = 0 ; g < 4 ; g++ ) {
+	rval += hg[2*k] * wg[g] * eg[1+8*k+g] / sg[1+8*k+g];
+	rval += hg[2*k+1] * wg[g] * eg[5+8*k+g] / sg[5+8*k+g];
+      }
+      t->roff[k+1] = t->roff[k] + 0.5 * log(10.0) * ap * rval;
+    }
+    free(lg);
+    free(eg);
+    free(sg);
+    free(hg);
+
+    for ( int k = 0 ; k < nseg ; k++ ) {
+      atomic_init(&t->built[k],0);
+    }
+    atomic_init(&t->complete,0);
+  }
+
+  TRACE_END(t0,"rtab_make","\"icorr\":%d,\"zp\":%d,\"ap\":%d,\"iabso\":%d,\"zt\":%d,\"lazy\":%d",
+	    t->icorr,t->zp,t->ap,t->iabso,t->zt,lz);
+  return t;
 }
 
 /*
-  Calculates a table of -dE/dx values given a projectile and
-  absorber.
+  Make the lazy table of the header h from the ranges roff at the first
+  point of its nseg segments, saved from a complete table built by
+  rtab_make(). Its segments are integrated on first use and end at the
+  saved ranges, so the table agrees with the complete one to rounding.
 */
-void dedxtab(int icorr, int zp, int ap, int iabso, int zt, int at,
-	     double e, double *tdedxe, double *tdedxn){
+struct rtab *rtab_load(const struct rtab *h, const double *roff, int nseg) {
 
-  double dedxn[NELMAX], dedxe[NELMAX];
-  double tw;
+  TRACE_BEGIN(t0);
+  struct rtab *t = rtab_alloc(h,0);
 
-  def_absorber(zt,at,iabso);
+  if ( t->nseg != nseg ) {
+    fprintf(stderr,"rangetab: packed table of %d segments, expected %d\n",nseg,t->nseg);
+    exit(EXIT_FAILURE);
+  }
+  for ( int k = 0 ; k < nseg ; k++ ) {
+    t->roff[k] = roff[k];
+    atomic_init(&t->built[k],0);
+  }
+  atomic_init(&t->complete,0);
+  TRACE_END(t0,"rtab_load","\"icorr\":%d,\"zp\":%d,\"ap\":%d,\"iabso\":%d,\"zt\":%d",
+	    t->icorr,t->zp,t->ap,t->iabso,t->zt);
+  return t;
+}
 
-  for ( int i = 0 ; i < numel ; i++ ) {
-    isw1 = false;
-    isw2 = false;
-    zt = cmpnd[i].z;
-    at = cmpnd[i].a;
-    if ( e < 2.5 ) {
-      dedxn[i] = ndedx(e,zp,ap,zt,at)*pow(zp,2);
-      dedxe[i] = ededx(e,zp,zt)*pow(zp,2);
-    }
-    else {
-      if ( icorr == 1 ) {
-	dedxn[i] = 0.0;
-	dedxe[i] = ededxh(e,zp,zt);
+/*
+  Build the electronic table of the header h: the electronic stopping
+  power of the absorber at the table points, and in place of the range
+  the range per nucleon without nuclear stopping. Its key has ap = 0.
+*/
+struct rtab *rtab_make_el(const struct rtab *h) {
+
+  TRACE_BEGIN(t0);
+  double se[NBLK], sn[NBLK], wtot = 0.0;
+  struct rtab *t = rtab_alloc(h,1);
+
+  t->ap = 0;
+  for ( int j = 0 ; j < t->n ; j++ ) {
+    t->se[j] = 0.0;
+  }
+  for ( int i = 0 ; i < t->numel ; i++ ) {
+    wtot += t->cmp[i].w;
+    for ( int j0 = 0 ; j0 < t->n ; j0 += NBLK ) {
+      int mb = t->n - j0 < NBLK ? t->n - j0 : NBLK;
+      dedx_v(t->icorr,&t->pair[i],&t->em[j0],j0,mb,se,sn);
+      for ( int j = 0 ; j < mb ; j++ ) {
+	t->se[j0+j] += se[j] * t->cmp[i].w;
       }
-      else {
-	dedxn[i] = ndedx(e,zp,ap,zt,at)*pow(zp,2);
-	dedxe[i] = ededx(e,zp,zt)*pow(zp,2);
+    }
+  }
+  for ( int j = 0 ; j < t->n ; j++ ) {
+    t->se[j] /= wtot;
+  }
+  rtab_integrate(t,1,t->se);
+  TRACE_END(t0,"rtab_make_el","\"icorr\":%d,\"zp\":%d,\"iabso\":%d,\"zt\":%d",
+	    t->icorr,t->zp,t->iabso,t->zt);
+  return t;
+}
+
+/*
+  Build the complete range table of the header h from the electronic
+  table el of the same element and absorber, adding the nuclear
+  stopping power of the isotope h->ap if nucl is not 0.
+*/
+struct rtab *rtab_scale(const struct rtab *h, const struct rtab *el, int nucl) {
+
+  TRACE_BEGIN(t0);
+  double sn[NBLK], wtot = 0.0;
+  struct rtab *t = rtab_alloc(h,0);
+  double *s = malloc(t->n*sizeof(double));
+
+  if ( s == NULL ) {
+    fprintf(stderr,"rangetab: out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  for ( int j = 0 ; j < t->n ; j++ ) {
+    s[j] = 0.0;
+  }
+  // no nuclear stopping where H-B-G alone is used
+  int nn = t->n;
+  while ( nn > 0 && corr_w(t->icorr,t->em[nn-1]) == 1.0 ) nn--;
+  for ( int i = 0 ; i < t->numel && nucl ; i++ ) {
+    wtot += t->cmp[i].w;
+    for ( int j0 = 0 ; j0 < nn ; j0 += NBLK ) {
+      int mb = nn - j0 < NBLK ? nn - j0 : NBLK;
+      sndx_v(t->icorr,&t->pair[i],&t->em[j0],mb,sn);
+      for ( int j = 0 ; j < mb ; j++ ) {
+	s[j0+j] += sn[j] * t->cmp[i].w;
       }
     }
   }
-  *tdedxn = *tdedxe = 0.0;
-  tw = 0.0;
-  for ( int i = 0 ; i < numel ; i++ ) {
-    *tdedxn += dedxn[i] * cmpnd[i].w;
-    *tdedxe += dedxe[i] * cmpnd[i].w;
-    tw += cmpnd[i].w;
+  for ( int j = 0 ; j < t->n ; j++ ) {
+    s[j] = el->se[j] + (nucl ? s[j] / wtot : 0.0);
   }
-  *tdedxn /= tw;
-  *tdedxe /= tw;
+  rtab_integrate(t,t->ap,s);
+  free(s);
+  TRACE_END(t0,"rtab_scale","\"icorr\":%d,\"zp\":%d,\"ap\":%d,\"iabso\":%d,\"zt\":%d",
+	    t->icorr,t->zp,t->ap,t->iabso,t->zt);
+  return t;
+}
+
+/*
+  Calculates a range table given projectile and absorber. Must be
+  called with the library lock held.
+*/
+struct rtab *rtab_build(int icorr, int zp, int ap, int iabso, int zt, int at) {
+  struct rtab h;
+  rtab_head(&h,icorr,zp,ap,iabso,zt,at);
+  return rtab_make(&h,rtab_lazy());
+}
+
+/*
+  Integrate segment k of a lazy table, starting from the range at its
+  first point. The trapezoidal integral is scaled to end exactly at the
+  range of the next segment, so that the table stays continuous and
+  does not depend on the order in which segments are built. Must be
+  called with the library lock held.
+*/
+void rtab_segment(struct rtab *t, int k) {
+
+  int j0, m, last;
+  double *e, *s, *p;
+  double scale;
+
+  TRACE_BEGIN(t0);
+  j0 = k * NSEG;
+  last = (k == t->nseg-1);
+  m = last ? t->n - j0 : NSEG + 1;
+
+  e = calloc(3*m,sizeof(double));
+  if ( e == NULL ) {
+    fprintf(stderr,"rangetab: out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  s = e + m;
+  p = s + m;
+  vexp10(&t->em[j0],e,m);
+  rtab_dedx(t,&t->em[j0],j0,m,s);
+
+  p[0] = 0.0;
+  for ( int j = 1 ; j < m ; j++ ) {
+    p[j] = p[j-1] + 0.5 * (1.0/s[j-1] + 1.0/s[j]) * (e[j] - e[j-1]) * t->ap;
+  }
+  scale = last ? 1.0 : (t->roff[k+1] - t->roff[k]) / p[m-1];
+
+  t->r[j0] = t->roff[k];
+  for ( int j = 1 ; j < (last ? m : m-1) ; j++ ) {
+    t->r[j0+j] = t->roff[k] + scale * p[j];
+  }
+  free(e);
+
+  TRACE_END(t0,"rtab_segment","\"zp\":%d,\"ap\":%d,\"zt\":%d,\"segment\":%d",
+	    t->zp,t->ap,t->zt,k);
+  atomic_store_explicit(&t->built[k],1,memory_order_release);
+  for ( int i = 0 ; i < t->nseg ; i++ ) {
+    if ( !atomic_load_explicit(&t->built[i],memory_order_relaxed) ) return;
+  }
+  atomic_store_explicit(&t->complete,1,memory_order_release);
+}
+
+/*
+  Free a table returned by rtab_build().
+*/
+void rtab_free(struct rtab *t) {
+  free(t);
+}
+
+/*
+  Calculates a range table given projectile and absorber, and copies
+  it to em and r. Tables are saved in the table cache to speed up
+  calculations.
+*/
+void rangetab(int icorr, int zp, int ap, int iabso, int zt, int at,
+	      double *em, double *r, int *n){
+
+  const struct rtab *t;
+
+  range_enter();
+  t = rtab_get(icorr,zp,ap,iabso,zt,at);
+  rtab_complete(t);
+  for ( int j = 0 ; j < t->n ; j++ ) {
+    *(em+j) = t->em[j];
+    *(r+j) = t->r[j];
+  }
+  *n = t->n;
+  range_leave();
+}
+
+/*
+  Calculates the electronic and nuclear -dE/dx (MeV/(mg/cm2)) of a
+  projectile in an absorber at n energies e (MeV/A). The stopping power
+  data are those of the range table with the same key, taken from the
+  table cache, so only the first call for a key prepares them.
+*/
+void dedxtab_v(int icorr, int zp, int ap, int iabso, int zt, int at,
+	       int n, const double *e, double *tdedxe, double *tdedxn) {
+
+  double el[NBLK], se[NBLK], sn[NBLK], tw = 0.0;
+  const struct rtab *t;
+
+  range_enter();
+  t = rtab_get(icorr,zp,ap,iabso,zt,at);
+  for ( int i = 0 ; i < t->numel ; i++ ) {
+    tw += t->cmp[i].w;
+  }
+  for ( int j0 = 0 ; j0 < n ; j0 += NBLK ) {
+    int m = n - j0 < NBLK ? n - j0 : NBLK;
+    vlog10(&e[j0],el,m);
+    for ( int j = 0 ; j < m ; j++ ) {
+      tdedxe[j0+j] = tdedxn[j0+j] = 0.0;
+    }
+    for ( int i = 0 ; i < t->numel ; i++ ) {
+      dedx_v(icorr,&t->pair[i],el,-1,m,se,sn);
+      for ( int j = 0 ; j < m ; j++ ) {
+	tdedxe[j0+j] += se[j] * t->cmp[i].w;
+	tdedxn[j0+j] += sn[j] * t->cmp[i].w;
+      }
+    }
+    for ( int j = 0 ; j < m ; j++ ) {
+      tdedxe[j0+j] /= tw;
+      tdedxn[j0+j] /= tw;
+    }
+  }
+  range_leave();
+}
+
+/*
+  Calculates -dE/dx at one energy e (MeV/A).
+*/
+void dedxtab(int icorr, int zp, int ap, int iabso, int zt, int at,
+	     double e, double *tdedxe, double *tdedxn){
+  dedxtab_v(icorr,zp,ap,iabso,zt,at,1,&e,tdedxe,tdedxn);
 }
 
 #ifdef __cplusplus
@@ -0,0 +1,210 @@
+/*
+  Author: Ricardo Yanez
+
+  Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+
+  Array versions of exp(), 10^x and log10() for the table builds and
+  the lookups, and scalar versions giving the same results. The loops
+  use only arithmetic and 64-bit integer operations on each element,
+  so that the compiler vectorizes them, and are compiled for AVX2 and
+  for the baseline instruction set, the version being selected at run
+  time. The file is compiled without contraction of multiply-adds, so
+  that all versions give the same results.
+
+  Accuracy, measured against long double on 10^7 random arguments:
+
+    vexp10(), sexp10()  max error 1.5 ULP  (|x| < 307)
+    vexp(), sexp()      max error 1.2 ULP  (|x| < 708)
+    vlog10(), slog10()  max error 3.3 ULP  (normal x > 0)
+
+  Arguments outside these intervals, infinities and NaN are passed to
+  the C library.
+
+  License:
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+#include "rangetab.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(__clang__)
+# define RANGE_CLONES __attribute__((target_clones("avx2","default")))
+#else
+# define RANGE_CLONES
+#endif
+
+// Elements per block
+#define NVEC 64
+
+// Adding and subtracting 1.5*2^52 rounds to the nearest integer
+#define SHIFT 6755399441055744.0
+
+#define LOG2_10 3.321928094887362
+#define LOG2E 1.4426950408889634
+#define LOG10E 0.4342944819032518
+
+// log10(2) and log(2) split so that k*hi is exact
+#define LOG10_2HI 0.30102992057800293
+#define LOG10_2LO 7.508597826552624e-08
+#define LN2HI 0.6931467056274414
+#define LN2LO 4.7493250390316726e-07
+
+static inline uint64_t bits(double x) {
+  uint64_t u;
+  memcpy(&u,&x,sizeof(u));
+  return u;
+}
+
+static inline double real(uint64_t u) {
+  double x;
+  memcpy(&x,&u,sizeof(x));
+  return x;
+}
+
+/*
+  10^x = 2^k 10^r with |r| <= log10(2)/2. 10^r is the Taylor series of
+  exp(r ln10) to 14 terms, with the coefficients (ln10)^k/k!. The
+  integer k is in the low bits of x*log2(10) + SHIFT, and 2^k is built
+  from them directly.
+*/
+static inline double exp10_k(double x) {
+  double t = x * LOG2_10 + SHIFT;
+  double k = t - SHIFT;
+  double r = (x - k * LOG10_2HI) - k * LOG10_2LO;
+  double p = 1.3508629476223687e-06;
+  p = p * r + 8.213412535439387e-06;
+  p = p * r + 4.6371516642572196e-05;
+  p = p * r + 0.00024166672554424694;
+  p = p * r + 0.0011544997789984348;
+  p = p * r + 0.00501392883377544;
+  p = p * r + 0.019597694626478524;
+  p = p * r + 0.06808936507443707;
+  p = p * r + 0.2069958486968681;
+  p = p * r + 0.5393829291955814;
+  p = p * r + 1.171255148912267;
+  p = p * r + 2.034678592293476;
+  p = p * r + 2.650949055239199;
+  p = p * r + 2.302585092994046;
+  return (1.0 + p * r) * real((bits(t) + 1023) << 52);
+}
+
+/*
+  exp(x) = 2^k exp(r) with |r| <= log(2)/2.
+*/
+static inline double exp_k(double x) {
+  double t = x * LOG2E + SHIFT;
+  double k = t - SHIFT;
+  double r = (x - k * LN2HI) - k * LN2LO;
+  double p = 1.6059043836821613e-10;
+  p = p * r + 2.08767569878681e-09;
+  p = p * r + 2.505210838544172e-08;
+  p = p * r + 2.755731922398589e-07;
+  p = p * r + 2.7557319223985893e-06;
+  p = p * r + 2.48015873015873e-05;
+  p = p * r + 0.0001984126984126984;
+  p = p * r + 0.001388888888888889;
+  p = p * r + 0.008333333333333333;
+  p = p * r + 0.041666666666666664;
+  p = p * r + 0.16666666666666666;
+  p = p * r + 0.5;
+  p = p * r + 1.0;
+  return (1.0 + p * r) * real((bits(t) + 1023) << 52);
+}
+
+/*
+  log10(x) = k log10(2) + log(m)/ln10 with x = 2^k m and m in
+  [sqrt(2)/2,sqrt(2)). log(m) = 2 atanh(f), f = (m-1)/(m+1), is summed
+  to 11 terms in f^2.
+*/
+static inline double log10_k(double x) {
+  uint64_t u = bits(x);
+  uint64_t b = u & 0x000fffffffffffffULL;
+  // 1 if the mantissa is above sqrt(2), then halve it
+  uint64_t h = (b + 0x00095f619980c433ULL) >> 52;
+  double m = real(b | ((0x3ffULL - h) << 52));
+  double k = real(0x4330000000000000ULL | ((u >> 52) + h)) - 4503599627371519.0;
+  double f = (m - 1.0) / (m + 1.0);
+  double s = f * f;
+  double p = 0.047619047619047616;
+  p = p * s + 0.05263157894736842;
+  p = p * s + 0.058823529411764705;
+  p = p * s + 0.06666666666666667;
+  p = p * s + 0.07692307692307693;
+  p = p * s + 0.09090909090909091;
+  p = p * s + 0.1111111111111111;
+  p = p * s + 0.14285714285714285;
+  p = p * s + 0.2;
+  p = p * s + 0.3333333333333333;
+  double l = 2.0 * f + 2.0 * f * (p * s);
+  return k * LOG10_2HI + (k * LOG10_2LO + l * LOG10E);
+}
+
+#define EXP10_OK(x) (fabs(x) < 307.0)
+#define EXP_OK(x) (fabs(x) < 708.0)
+#define LOG10_OK(x) ((x) >= DBL_MIN && (x) <= DBL_MAX)
+
+/*
+  The array versions work on blocks of NVEC elements. The block of x is
+  copied, so that y may be x, and the elements out of range are passed
+  to the C library after the block.
+*/
+#define KERNEL(name,kern,ok,libm)					\
+  RANGE_CLONES								\
+  void name(const double *x, double *y, int n) {			\
+    double xb[NVEC];							\
+    for ( int i0 = 0 ; i0 < n ; i0 += NVEC ) {				\
+      int m = n - i0 < NVEC ? n - i0 : NVEC;				\
+      memcpy(xb,x+i0,m*sizeof(double));					\
+      for ( int i = 0 ; i < m ; i++ ) {					\
+	y[i0+i] = kern(xb[i]);						\
+      }									\
+      for ( int i = 0 ; i < m ; i++ ) {					\
+	if ( !ok(xb[i]) ) y[i0+i] = libm;				\
+      }									\
+    }									\
+  }
+
+KERNEL(vexp10,exp10_k,EXP10_OK,pow(10.0,xb[i]))
+KERNEL(vexp,exp_k,EXP_OK,exp(xb[i]))
+KERNEL(vlog10,log10_k,LOG10_OK,log10(xb[i]))
+
+/*
+  Scalar versions, with the same results as the array versions.
+*/
+double sexp10(double x) {
+  return EXP10_OK(x) ? exp10_k(x) : pow(10.0,x);
+}
+
+double sexp(double x) {
+  return EXP_OK(x) ? exp_k(x) : exp(x);
+}
+
+double slog10(double x) {
+  return LOG10_OK(x) ? log10_k(x) : log10(x);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,106 @@
+/*
+  Author: Ricardo Yanez
+
+  Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+
+  The table pack. The range tables of the light ions most often used,
+  p, d, t, 3He and 4He, in the pre-defined absorbers and a few common
+  elements, and the stopping power data of their projectiles and
+  absorber elements, are generated when the library is built
+  (rangepackgen.c) and linked into it as constant data. A table is
+  kept as the range at the first point of each segment, a tenth of a
+  kilobyte, and loaded into the table cache as a lazy table instead of
+  being calculated; the segments used are integrated between the
+  packed ranges.
+
+  Compiled without RANGE_PACK, for the generator itself or with the
+  CMake option RANGE_PACK off, the pack is empty.
+
+  License:
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+
+*/
+
+#include <stddef.h>
+
+#include "range.h"
+#include "rangetab.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef RANGE_PACK
+const struct rpack rtab_pack[1];
+const int rtab_npack = 0;
+const struct rside rtab_pack_sides[1];
+const int rtab_npack_sides = 0;
+const struct rproj rtab_pack_projs[1];
+const int rtab_npack_projs = 0;
+#endif
+
+// Order of the keys of the pack
+static int cmp_key(const struct rpack *p, int icorr, int zp, int ap, int iabso,
+		   int zt, int at) {
+  int a[6] = {p->icorr,p->zp,p->ap,p->iabso,p->zt,p->at};
+  int b[6] = {icorr,zp,ap,iabso,zt,at};
+  for ( int i = 0 ; i < 6 ; i++ ) {
+    if ( a[i] != b[i] ) return a[i] < b[i] ? -1 : 1;
+  }
+  return 0;
+}
+
+/*
+  Return the table of the given key in the pack, or NULL.
+*/
+const struct rpack *rtab_pack_find(int icorr, int zp, int ap, int iabso, int zt, int at) {
+  int lo = 0, hi = rtab_npack;
+  // single elements are keyed by zt and at, compounds by iabso
+  if ( iabso != 0 ) zt = at = 0;
+  while ( lo < hi ) {
+    int mid = (lo + hi) / 2, c = cmp_key(&rtab_pack[mid],icorr,zp,ap,iabso,zt,at);
+    if ( c == 0 ) return &rtab_pack[mid];
+    if ( c < 0 )
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return NULL;
+}
+
+/*
+  Return the absorber data of element zt in the pack, or NULL.
+*/
+const struct rside *rtab_pack_side(int zt) {
+  for ( int i = 0 ; i < rtab_npack_sides ; i++ ) {
+    if ( rtab_pack_sides[i].zt == zt ) return &rtab_pack_sides[i];
+  }
+  return NULL;
+}
+
+/*
+  Return the projectile data of charge zp in the pack, or NULL.
+*/
+const struct rproj *rtab_pack_proj(int zp) {
+  for ( int i = 0 ; i < rtab_npack_projs ; i++ ) {
+    if ( rtab_pack_projs[i].zp == zp ) return &rtab_pack_projs[i];
+  }
+  return NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,163 @@
+/*
+  Author: Ricardo Yanez
+
+  Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+
+  Generator of the table pack (rangepack.c). Builds the tables of the
+  pack with the library, linked with an empty pack, and writes them to
+  the file given as argument as C source defining the pack data: the
+  range at the first point of each segment of the complete tables, and
+  the stopping power data. The numbers are written in hexadecimal
+  floating point, so they are those the library calculates, bit for
+  bit.
+
+  License:
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "range.h"
+#include "rangetab.h"
+
+// Light ions: p, d, t, 3He and 4He
+static const int ions[][2] = {{1,1},{1,2},{1,3},{2,3},{2,4}};
+
+// Pre-defined absorbers, and Si, Al and Au
+static const int absos[][3] = {
+  {1,0,0},{2,0,0},{3,0,0},{4,0,0},{5,0,0},{6,0,0},{7,0,0},{8,0,0},{9,0,0},
+  {10,0,0},{11,0,0},{12,0,0},{100,0,0},{101,0,0},{102,0,0},{103,0,0},
+  {0,13,27},{0,14,28},{0,79,197}
+};
+
+#define NION (int)(sizeof(ions)/sizeof(ions[0]))
+#define NABSO (int)(sizeof(absos)/sizeof(absos[0]))
+
+// The tables of both correlations, which passage() switches between
+#define NCORR 2
+#define NKEY (NCORR*NION*NABSO)
+
+static void emit(FILE *fp, const double *x, int n) {
+  fprintf(fp,"{");
+  for ( int j = 0 ; j < n ; j++ ) {
+    fprintf(fp,"%s%a",j % 4 ? "," : (j ? ",\n  " : "\n  "),x[j]);
+  }
+  fprintf(fp,"}");
+}
+
+static int cmp_key(const void *p, const void *q) {
+  const struct range_key *a = p, *b = q;
+  int ka[6] = {a->icorr,a->zp,a->ap,a->iabso,a->zt,a->at};
+  int kb[6] = {b->icorr,b->zp,b->ap,b->iabso,b->zt,b->at};
+  for ( int i = 0 ; i < 6 ; i++ ) {
+    if ( ka[i] != kb[i] ) return ka[i] < kb[i] ? -1 : 1;
+  }
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+
+  struct range_key key[NKEY];
+  int zt[ZMAX+1] = {0}, zp[ZMAX+1] = {0};
+  int nkey = 0, nside = 0, nproj = 0;
+  FILE *fp;
+
+  if ( argc != 2 ) {
+    fprintf(stderr,"usage: %s file.c\n",argv[0]);
+    return EXIT_FAILURE;
+  }
+  if ( (fp = fopen(argv[1],"w")) == NULL ) {
+    fprintf(stderr,"%s: cannot open %s\n",argv[0],argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  for ( int c = 0 ; c < NCORR ; c++ ) {
+    for ( int i = 0 ; i < NION ; i++ ) {
+      for ( int k = 0 ; k < NABSO ; k++ ) {
+	key[nkey++] = (struct range_key){c,ions[i][0],ions[i][1],
+					 absos[k][0],absos[k][1],absos[k][2]};
+      }
+    }
+  }
+  qsort(key,nkey,sizeof(struct range_key),cmp_key);
+  range_build(key,nkey,0);
+
+  fprintf(fp,"/* Table pack of rangelib, generated by rangepackgen. Do not edit. */\n\n");
+  fprintf(fp,"#include \"rangetab.h\"\n\n");
+
+  range_enter();
+  for ( int i = 0 ; i < nkey ; i++ ) {
+    const struct range_key *k = &key[i];
+    const struct rtab *t = rtab_find(k->icorr,k->zp,k->ap,k->iabso,k->zt,k->at);
+    fprintf(fp,"static const double roff_%d[%d] = ",i,t->nseg);
+    emit(fp,t->roff,t->nseg);
+    fprintf(fp,";\n\n");
+    zp[k->zp] = 1;
+    for ( int j = 0 ; j < t->numel ; j++ ) {
+      zt[t->cmp[j].z] = 1;
+    }
+  }
+
+  fprintf(fp,"const struct rpack rtab_pack[] = {\n");
+  for ( int i = 0 ; i < nkey ; i++ ) {
+    const struct range_key *k = &key[i];
+    const struct rtab *t = rtab_find(k->icorr,k->zp,k->ap,k->iabso,k->zt,k->at);
+    fprintf(fp,"  {%d,%d,%d,%d,%d,%d,%d,roff_%d},\n",k->icorr,k->zp,k->ap,k->iabso,
+	    k->zt,k->at,t->nseg,i);
+  }
+  fprintf(fp,"};\n\nconst int rtab_npack = %d;\n\n",nkey);
+  range_leave();
+
+  // The stopping power data, prepared by the builds
+  range_lock();
+  fprintf(fp,"const struct rside rtab_pack_sides[] = {\n");
+  for ( int z = 1 ; z <= ZMAX ; z++ ) {
+    if ( !zt[z] ) continue;
+    const struct rside *s = rside_get(z);
+    fprintf(fp,"  {.zt = %d,\n   .elog = ",z);
+    emit(fp,s->elog,42);
+    fprintf(fp,",\n   .ftarg = ");
+    emit(fp,s->ftarg,42);
+    fprintf(fp,",\n   .s2 = ");
+    emit(fp,s->s2,38);
+    fprintf(fp,",\n   .s2y2 = ");
+    emit(fp,s->s2y2,38);
+    fprintf(fp,",\n   .b = %a, .c = %a, .d = %a, .x2 = %a, .x3 = %a, .x4 = %a},\n",
+	    s->b,s->c,s->d,s->x2,s->x3,s->x4);
+    nside++;
+  }
+  fprintf(fp,"};\n\nconst int rtab_npack_sides = %d;\n\n",nside);
+
+  fprintf(fp,"const struct rproj rtab_pack_projs[] = {\n");
+  for ( int z = 1 ; z <= ZMAX ; z++ ) {
+    if ( !zp[z] ) continue;
+    const struct rproj *p = rproj_get(z);
+    fprintf(fp,"  {.zp = %d,\n   .dedxz2 = ",z);
+    emit(fp,p->dedxz2,42);
+    fprintf(fp,"},\n");
+    nproj++;
+  }
+  fprintf(fp,"};\n\nconst int rtab_npack_projs = %d;\n",nproj);
+  range_unlock();
+
+  if ( fclose(fp) != 0 ) {
+    fprintf(stderr,"%s: cannot write %s\n",argv[0],argv[1]);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
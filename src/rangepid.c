@@ -0,0 +1,147 @@
+/*
+  Author: Ricardo Yanez
+
+  Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+
+  Particle identification in Delta E - E telescopes. The Delta E - E
+  locus of each candidate isotope is calculated once from the range
+  tables on a grid uniform in log(E/A) of the residual energy, so that
+  an event is compared with a locus by direct indexing and linear
+  interpolation.
+
+  License:
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "rangetab.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Points of a locus and its limits in log10(E/A) of the residual energy
+#define NPID 512
+#define PID_XLO -2.0
+#define PID_XHI 2.5
+
+struct locus {
+  int zp, ap;
+  double x0;        // log10(A) + PID_XLO
+  double de[NPID];  // Delta E at the grid points (MeV)
+};
+
+struct range_pid {
+  int nion;
+  struct locus *ion;
+};
+
+/*
+  Energy of an ion before a layer, from the energy after it.
+*/
+static double back(int icorr, int zp, int ap, const struct range_layer *l,
+		   double eut) {
+  double err;
+  if ( icorr == 0 && eut/ap > 12.0 ) icorr = 1;  // switch to H-B-G
+  const struct rtab *tab = rtab_get(icorr,zp,ap,l->iabso,l->zt,l->at);
+  return rtab_egassap(tab,ap,l->t,eut,&err)*ap;
+}
+
+/*
+  Calculate the Delta E - E loci of nion isotopes zp[i], ap[i] in a
+  telescope of nlayer layers. The energy loss is measured in layer 0,
+  layers 1 to nlayer-1 are dead layers, and the residual energy is
+  measured in a detector after the last layer which stops the ion.
+*/
+struct range_pid *range_pid_new(int icorr, const struct range_layer *layer,
+				int nlayer, const int *zp, const int *ap, int nion) {
+
+  struct range_pid *pid = malloc(sizeof(struct range_pid));
+  if ( pid == NULL || (pid->ion = malloc(nion*sizeof(struct locus))) == NULL ) {
+    fprintf(stderr,"range_pid: out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  pid->nion = nion;
+
+  range_enter();
+  for ( int i = 0 ; i < nion ; i++ ) {
+    struct locus *l = &pid->ion[i];
+    l->zp = zp[i];
+    l->ap = ap[i];
+    l->x0 = log10(ap[i]) + PID_XLO;
+    for ( int j = 0 ; j < NPID ; j++ ) {
+      double x = PID_XLO + (PID_XHI - PID_XLO) * j / (NPID - 1);
+      double e = pow(10.0,x)*ap[i];
+      for ( int k = nlayer-1 ; k > 0 ; k-- ) {
+	e = back(icorr,zp[i],ap[i],&layer[k],e);
+      }
+      l->de[j] = back(icorr,zp[i],ap[i],&layer[0],e) - e;
+    }
+  }
+  range_leave();
+
+  return pid;
+}
+
+void range_pid_free(struct range_pid *pid) {
+  if ( pid == NULL ) return;
+  free(pid->ion);
+  free(pid);
+}
+
+/*
+  Classify n events with energy loss de[] and residual energy e[]. The
+  isotope of the nearest locus is stored in zp[] and ap[], and the
+  relative distance (de - de_locus)/de_locus at the same residual
+  energy in dist[]. Events outside all loci get zp = ap = 0 and
+  dist = HUGE_VAL.
+*/
+void range_pid_classify(const struct range_pid *pid, int n, const double *de,
+			const double *e, int *zp, int *ap, double *dist) {
+
+  const double h = (NPID - 1) / (PID_XHI - PID_XLO);
+
+  for ( int k = 0 ; k < n ; k++ ) {
+    double best = HUGE_VAL;
+    zp[k] = 0;
+    ap[k] = 0;
+    dist[k] = HUGE_VAL;
+    if ( e[k] <= 0.0 || de[k] <= 0.0 ) continue;
+    double lge = log10(e[k]);
+    for ( int i = 0 ; i < pid->nion ; i++ ) {
+      const struct locus *l = &pid->ion[i];
+      double u = (lge - l->x0) * h;
+      if ( u < 0.0 || u > NPID - 1 ) continue;
+      int j = u < NPID - 1 ? (int)u : NPID - 2;
+      double f = l->de[j] + (u - j) * (l->de[j+1] - l->de[j]);
+      double d = (de[k] - f) / f;
+      if ( fabs(d) < best ) {
+	best = fabs(d);
+	zp[k] = l->zp;
+	ap[k] = l->ap;
+	dist[k] = d;
+      }
+    }
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -35,18 +35,142 @@
 #include <stdlib.h>
 #include <math.h>
 
-#ifndef _NMAX
-#define _NMAX
-# define NMAX 4000
-#endif
-
+#include "rangetab.h"
 #include "nr.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-void rangetab(int, int, int, int, int, int, double*, double*, int*);
+/*
+  Interpolate the range at elg = log10(E/A) in a range table.
+*/
+double rtab_range(const struct rtab *t, double elg, double *err) {
+  int jj = nr_locate(t->em,t->n,elg);
+  if ( jj > t->n-3 ) jj = t->n-3;
+  if ( !atomic_load_explicit(&t->complete,memory_order_acquire) ) {
+    rtab_need(t,jj/NSEG);
+    rtab_need(t,(jj+2)/NSEG);
+  }
+  double r = nr_polint(&t->em[jj],&t->r[jj],3,elg,err);
+  if ( atomic_load_explicit(&rtab_tel,memory_order_relaxed) ) {
+    rtab_note(t,jj,r != 0.0 ? fabs(*err/r) : 0.0);
+  }
+  return r;
+}
+
+/*
+  Index of the last of y[lo..hi] below x, or lo (as nr_locate).
+*/
+static int seg_locate(const double *y, int lo, int hi, double x) {
+  int jl = lo, ju = hi+1;
+  if ( x <= y[lo] ) return lo;
+  while ( ju - jl > 1 ) {
+    int jm = (ju + jl) / 2;
+    if ( x > y[jm] )
+      jl = jm;
+    else
+      ju = jm;
+  }
+  return jl;
+}
+
+/*
+  Interpolate log10(E/A) at range rng in a range table. In a lazy
+  table the segment is found from the range at the first point of
+  each segment, so that only the segments around rng are built.
+*/
+double rtab_energy(const struct rtab *t, double rng, double *err) {
+  int jj;
+  if ( atomic_load_explicit(&t->complete,memory_order_acquire) ) {
+    jj = nr_locate(t->r,t->n,rng);
+  }
+  else {
+    int k = seg_locate(t->roff,0,t->nseg-1,rng);
+    int j0 = k * NSEG;
+    int j1 = (k == t->nseg-1) ? t->n-1 : j0 + NSEG - 1;
+    rtab_need(t,k);
+    jj = seg_locate(t->r,j0,j1,rng);
+  }
+  if ( jj > t->n-3 ) jj = t->n-3;
+  if ( !atomic_load_explicit(&t->complete,memory_order_acquire) ) {
+    rtab_need(t,jj/NSEG);
+    rtab_need(t,(jj+2)/NSEG);
+  }
+  double elg = nr_polint(&t->r[jj],&t->em[jj],3,rng,err);
+  if ( atomic_load_explicit(&rtab_tel,memory_order_relaxed) ) {
+    rtab_note(t,jj,fabs(*err)*M_LN10);
+  }
+  return elg;
+}
+
+// Hits per block of rtab_passage_v()
+#define NBLK 64
+
+/*
+  Energy of ion after passage through an absorber foil of thickness
+  t[i], from a range table, for m <= NBLK ions of energy ein[i]. The
+  logarithms and powers of the block are calculated an array at a time.
+*/
+static void rtab_passage_v(const struct rtab *tab, int ap, const double *ein,
+			   const double *t, int m, double *eut, double *err) {
+
+  double elin[NBLK] = {0.0}, p[3*NBLK];  // zeroed for -Wmaybe-uninitialized
+  double rut, lerr;
+
+  for ( int i = 0 ; i < m ; i++ ) {
+    elin[i] = ein[i]/ap;
+  }
+  vlog10(elin,elin,m);
+  for ( int i = 0 ; i < m ; i++ ) {
+    rut = rtab_range(tab,elin[i],&lerr) - t[i];
+    if ( rut <= 0.0 ) {
+      // stopped, 10^-inf = 0
+      p[3*i] = p[3*i+1] = p[3*i+2] = -HUGE_VAL;
+    }
+    else {
+      double elut = rtab_energy(tab,rut,&lerr);
+      p[3*i] = elut-lerr*3;
+      p[3*i+1] = elut+lerr*3;
+      p[3*i+2] = elut;
+    }
+  }
+  vexp10(p,p,3*m);
+  for ( int i = 0 ; i < m ; i++ ) {
+    if ( p[3*i+2] == 0.0 ) {
+      err[i] = 0.0;
+      eut[i] = 0.0;
+    }
+    else {
+      err[i] = fabs(p[3*i]-p[3*i+1])/p[3*i+2];
+      eut[i] = p[3*i+2]*ap;
+    }
+  }
+}
+
+/*
+  As rtab_passage_v() for one ion, with the same results.
+*/
+static double rtab_passage(const struct rtab *tab, int ap, double ein,
+			   double t, double *err) {
+
+  double eut, elin, elut, rin, rut, lerr, eu;
+
+  elin = slog10(ein/ap);
+  rin = rtab_range(tab,elin,&lerr);
+  rut = rin - t;
+  if ( rut <= 0.0 ) {
+    *err = 0.0;
+    eut = 0.0;
+  }
+  else {
+    elut = rtab_energy(tab,rut,&lerr);
+    eu = sexp10(elut);
+    *err = fabs(sexp10(elut-lerr*3)-sexp10(elut+lerr*3))/eu;
+    eut = eu*ap;
+  }
+  return eut;
+}
 
 /*
   Calculate energy of ion after passage through an absorber foil.
@@ -54,22 +178,18 @@ void rangetab(int, int, int, int, int, int, double*, double*, int*);
 double passage(int icorr, int zp, int ap, int iabso, int zt, int at,
 	       double ein, double t, double *err) {
 
-  double eut, elin, elut, rin, rut, lerr;
-  int n;
-
-  int jj, jjj;
+  double eut;
+  const struct rtab *tab;
 
   // check correlation
   if ( icorr == 0 && ein/ap > 12.0 ) icorr = 1;  // switch to H-B-G
   if ( icorr == 1 && ein/ap <= 2.5 ) icorr = 0;  // switch to N-S
 
-  double *em = malloc(NMAX*sizeof(double));
-  double *r = malloc(NMAX*sizeof(double));
-
-  rangetab(icorr,zp,ap,iabso,zt,at,em,r,&n);
-  jjj = n-3;
+  range_enter();
+  tab = rtab_get(icorr,zp,ap,iabso,zt,at);
 
 #ifdef _DEBUG
+  rtab_complete(tab);
   FILE *fd;
   if ( icorr == 0 ) {
     fd = fopen("rangetab_ns.dat","w");
@@ -77,36 +197,150 @@ double passage(int icorr, int zp, int ap, int iabso, int zt, int at,
   else {
     fd = fopen("rangetab_hbg.dat","w");
   }
-  for ( int i = 0 ; i < n ; i++ ) {
-    fprintf(fd,"%f\t%f\n",pow(10.0,em[i]),r[i]);
+  for ( int i = 0 ; i < tab->n ; i++ ) {
+    fprintf(fd,"%f\t%f\n",pow(10.0,tab->em[i]),tab->r[i]);
   }
   fclose(fd);
 #endif
 
-  elin = log10(ein/ap);
-  jj = nr_locate(em,n,elin);
-  if ( jj > jjj ) jj = jjj;
-  rin = nr_polint(&em[jj],&r[jj],3,elin,&lerr);
-  rut = rin - t;
-  if ( rut <= 0.0 ) {
-    *err = 0.0;
-    eut = 0.0;
+  eut = rtab_passage(tab,ap,ein,t,err);
+  range_leave();
+
+  if ( atomic_load_explicit(&rtab_shadow_on,memory_order_relaxed) ) {
+    rtab_shadow(RANGE_PASSAGE,icorr,zp,ap,iabso,zt,at,ein,t,eut);
+  }
+  return eut;
+}
+
+/*
+  Slope dR/dlog10(E/A) at x of the polynomial through table points jj
+  to jj+2.
+*/
+static double rtab_slope(const struct rtab *t, int jj, double x) {
+  const double *xa = &t->em[jj], *ya = &t->r[jj];
+  return ya[0] * ((x-xa[1]) + (x-xa[2])) / ((xa[0]-xa[1]) * (xa[0]-xa[2]))
+    + ya[1] * ((x-xa[0]) + (x-xa[2])) / ((xa[1]-xa[0]) * (xa[1]-xa[2]))
+    + ya[2] * ((x-xa[0]) + (x-xa[1])) / ((xa[2]-xa[0]) * (xa[2]-xa[1]));
+}
+
+/*
+  Stopping power (MeV/(mg/cm2)) of an ion of energy e (MeV), from the
+  slope of the interpolating polynomial of the range table.
+*/
+static double rtab_stop(const struct rtab *t, int ap, double e) {
+  double x = log10(e/ap);
+  int jj = nr_locate(t->em,t->n,x);
+  if ( jj > t->n-3 ) jj = t->n-3;
+  if ( !atomic_load_explicit(&t->complete,memory_order_acquire) ) {
+    rtab_need(t,jj/NSEG);
+    rtab_need(t,(jj+2)/NSEG);
+  }
+  return e * log(10.0) / rtab_slope(t,jj,x);
+}
+
+/*
+  Energy after passage and its derivatives with respect to the energy
+  before passage and to the thickness, dEout/dEin = S(Eout)/S(Ein) and
+  dEout/dt = -S(Eout).
+*/
+static double rtab_passage_d(const struct rtab *tab, int ap, double ein,
+			     double t, double *err, double *dein, double *dt) {
+  double eut = rtab_passage(tab,ap,ein,t,err);
+  if ( eut > 0.0 ) {
+    double sut = rtab_stop(tab,ap,eut);
+    *dein = sut / rtab_stop(tab,ap,ein);
+    *dt = -sut;
   }
   else {
-    jj = nr_locate(r,n,rut);
-    if ( jj > jjj ) jj = jjj;
-    elut = nr_polint(&r[jj],&em[jj],3,rut,&lerr);
-    *err = fabs(pow(10.0,elut-lerr*3)-pow(10.0,elut+lerr*3))/pow(10.0,elut);
-    eut = pow(10.0,elut)*ap;
+    *dein = 0.0;
+    *dt = 0.0;
   }
+  return eut;
+}
 
-  // free allocated memory
-  free(em);
-  free(r);
+/*
+  Calculate energy of ion after passage through an absorber foil, and
+  the derivatives dEout/dEin and dEout/dt.
+*/
+double passage_d(int icorr, int zp, int ap, int iabso, int zt, int at,
+		 double ein, double t, double *err, double *dein, double *dt) {
+
+  double eut;
+  const struct rtab *tab;
+
+  // check correlation
+  if ( icorr == 0 && ein/ap > 12.0 ) icorr = 1;  // switch to H-B-G
+  if ( icorr == 1 && ein/ap <= 2.5 ) icorr = 0;  // switch to N-S
+
+  range_enter();
+  tab = rtab_get(icorr,zp,ap,iabso,zt,at);
+  eut = rtab_passage_d(tab,ap,ein,t,err,dein,dt);
+  range_leave();
 
   return eut;
 }
 
+/*
+  Energy before passage through an absorber of thickness t, from a range
+  table, in MeV/A.
+*/
+double rtab_egassap(const struct rtab *tab, int ap, double t,
+		    double eut, double *err) {
+
+  double elut, elin, rut, rin, lerr;
+
+  if ( eut/ap != 0.0 ) {
+    elut = slog10(eut/ap);
+    rut = rtab_range(tab,elut,&lerr);
+  }
+  else {
+    rut = 0.0;
+  }
+
+  rin = rut + t;
+  elin = rtab_energy(tab,rin,&lerr);
+  *err = fabs(sexp10(elin-lerr*3)-sexp10(elin+lerr*3))/sexp10(elin);
+  return sexp10(elin);
+}
+
+/*
+  Result of passage(), egassap(), rangen() or thickn() (op RANGE_PASSAGE,
+  RANGE_EGASSAP, RANGE_RANGEN or RANGE_THICKN) with arguments x and y,
+  calculated from the range table t whatever the energy.
+*/
+double rtab_eval(const struct rtab *t, int op, double x, double y) {
+  double err, rut = 0.0;
+  switch(op) {
+  case RANGE_PASSAGE:
+    return rtab_passage(t,t->ap,x,y,&err);
+  case RANGE_EGASSAP:
+    return rtab_egassap(t,t->ap,x,y,&err)*t->ap;
+  case RANGE_RANGEN:
+    return rtab_range(t,log10(x/t->ap),&err);
+  case RANGE_THICKN:
+    if ( x-y > 0.0 ) {
+      rut = rtab_range(t,log10((x-y)/t->ap),&err);
+    }
+    return rtab_range(t,log10(x/t->ap),&err) - rut;
+  }
+  return 0.0;
+}
+
+/*
+  Energy before passage and its derivatives with respect to the energy
+  after passage and to the thickness, dEin/dEout = S(Ein)/S(Eout) and
+  dEin/dt = S(Ein). The derivative with respect to the energy after
+  passage is 0 if the ion is stopped.
+*/
+static double rtab_egassap_d(const struct rtab *tab, int ap, double t,
+			     double eut, double *err, double *deut, double *dt) {
+  double ein = rtab_egassap(tab,ap,t,eut,err)*ap;
+  double sein = rtab_stop(tab,ap,ein);
+  *deut = eut > 0.0 ? sein / rtab_stop(tab,ap,eut) : 0.0;
+  *dt = sein;
+  return ein;
+}
+
 /*
   Calculate incoming energy of ion before passage 
   through an absorber of thickness t.
@@ -114,37 +348,21 @@ double passage(int icorr, int zp, int ap, int iabso, int zt, int at,
 double egassap(int icorr, int zp, int ap, int iabso, int zt, int at,
 	       double t, double eut, double *err) {
 
-  double elut, elin, eaut, rut, rin, lerr;
-  int n;
-
-  int jj, jjj;
-
-  double *em = malloc(NMAX*sizeof(double));
-  double *r = malloc(NMAX*sizeof(double));
+  double eaut;
+  const struct rtab *tab;
 
   if ( eut/ap != 0.0 ) {
     if ( icorr == 0 && eut/ap > 12.0 ) icorr = 1;  // switch to H-B-G
   }
 
-  rangetab(icorr,zp,ap,iabso,zt,at,em,r,&n);
-  jjj = n-3;
+  range_enter();
+  tab = rtab_get(icorr,zp,ap,iabso,zt,at);
+  eaut = rtab_egassap(tab,ap,t,eut,err);
+  range_leave();
 
-  if ( eut/ap != 0.0 ) {
-    elut = log10(eut/ap);
-    jj = nr_locate(em,n,elut);
-    if (jj > jjj) jj = jjj;
-    rut = nr_polint(&em[jj],&r[jj],3,elut,&lerr);
+  if ( atomic_load_explicit(&rtab_shadow_on,memory_order_relaxed) ) {
+    rtab_shadow(RANGE_EGASSAP,icorr,zp,ap,iabso,zt,at,t,eut,eaut*ap);
   }
-  else {
-    rut = 0.0;
-  }
-
-  rin = rut + t;
-  jj = nr_locate(r,n,rin);
-  if ( jj > jjj ) jj = jjj;
-  elin = nr_polint(&r[jj],&em[jj],3,rin,&lerr);
-  *err = fabs(pow(10.0,elin-lerr*3)-pow(10.0,elin+lerr*3))/pow(10.0,elin);
-  eaut = pow(10.0,elin);
 
   if ( icorr == 0 && eaut > 12.0 ) {
     printf("warning: Hubert-Bimbot-Gauvin correlations should be used in this case.\n");
@@ -153,84 +371,476 @@ double egassap(int icorr, int zp, int ap, int iabso, int zt, int at,
     printf("Warning: Northcliffe-Schilling correlations should be used in this case.\n");
   }
 
-  // free allocated memory
-  free(em);
-  free(r);
-
   return eaut*ap;
 }
 
+/*
+  Calculate incoming energy of ion before passage through an absorber
+  of thickness t, and the derivatives dEin/dEout and dEin/dt.
+*/
+double egassap_d(int icorr, int zp, int ap, int iabso, int zt, int at,
+		 double t, double eut, double *err, double *deut, double *dt) {
+
+  double ein;
+  const struct rtab *tab;
+
+  if ( eut/ap != 0.0 ) {
+    if ( icorr == 0 && eut/ap > 12.0 ) icorr = 1;  // switch to H-B-G
+  }
+
+  range_enter();
+  tab = rtab_get(icorr,zp,ap,iabso,zt,at);
+  ein = rtab_egassap_d(tab,ap,t,eut,err,deut,dt);
+  range_leave();
+
+  if ( icorr == 0 && ein/ap > 12.0 ) {
+    printf("warning: Hubert-Bimbot-Gauvin correlations should be used in this case.\n");
+  }
+  if ( icorr == 1 && ein/ap <= 2.5 ) {
+    printf("Warning: Northcliffe-Schilling correlations should be used in this case.\n");
+  }
+
+  return ein;
+}
+
+/*
+  A hit of a batch, with the table key after the correlation switch.
+*/
+struct order {
+  struct range_key key;
+  int i;
+};
+
+static int key_cmp(const struct range_key *p, const struct range_key *q) {
+  if ( p->icorr != q->icorr ) return p->icorr < q->icorr ? -1 : 1;
+  if ( p->zp != q->zp ) return p->zp < q->zp ? -1 : 1;
+  if ( p->ap != q->ap ) return p->ap < q->ap ? -1 : 1;
+  if ( p->iabso != q->iabso ) return p->iabso < q->iabso ? -1 : 1;
+  if ( p->zt != q->zt ) return p->zt < q->zt ? -1 : 1;
+  if ( p->at != q->at ) return p->at < q->at ? -1 : 1;
+  return 0;
+}
+
+static int order_cmp(const void *a, const void *b) {
+  const struct order *p = a, *q = b;
+  int c = key_cmp(&p->key,&q->key);
+  return c != 0 ? c : p->i - q->i;
+}
+
+/*
+  Run a batch of n hits with mixed projectiles and absorbers. The hits
+  are grouped by range table, each group is calculated with its table
+  looked up once, and the results are stored in the order of the hits.
+  If dir is 0 the energy of a hit is before passage and e[] is the
+  energy after, if dir is 1 it is the reverse. The derivatives are
+  calculated if de is not NULL.
+*/
+static void batch(const struct range_hit *hit, int n, int dir,
+		  double *e, double *err, double *de, double *dt) {
+
+  struct order *ord;
+
+  if ( n <= 0 ) return;
+  ord = malloc(n*sizeof(struct order));
+  if ( ord == NULL ) {
+    fprintf(stderr,"rangelib: out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  for ( int i = 0 ; i < n ; i++ ) {
+    double ea = hit[i].ein/hit[i].key.ap;
+    ord[i].key = hit[i].key;
+    ord[i].i = i;
+    // check correlation
+    if ( dir == 0 ) {
+      if ( ord[i].key.icorr == 0 && ea > 12.0 ) ord[i].key.icorr = 1;
+      if ( ord[i].key.icorr == 1 && ea <= 2.5 ) ord[i].key.icorr = 0;
+    }
+    else {
+      if ( ord[i].key.icorr == 0 && ea > 12.0 ) ord[i].key.icorr = 1;
+    }
+  }
+  qsort(ord,n,sizeof(struct order),order_cmp);
+
+  range_enter();
+  for ( int lo = 0, hi ; lo < n ; lo = hi ) {
+    const struct range_key *k = &ord[lo].key;
+    const struct rtab *tab = rtab_get(k->icorr,k->zp,k->ap,k->iabso,k->zt,k->at);
+    for ( hi = lo ; hi < n && key_cmp(&ord[hi].key,k) == 0 ; hi++ );
+    if ( dir == 0 && de == NULL ) {
+      // passages in blocks, gathered in the order of the group
+      double ein[NBLK], t[NBLK], eut[NBLK], eerr[NBLK];
+      for ( int j0 = lo ; j0 < hi ; j0 += NBLK ) {
+	int m = hi - j0 < NBLK ? hi - j0 : NBLK;
+	for ( int j = 0 ; j < m ; j++ ) {
+	  ein[j] = hit[ord[j0+j].i].ein;
+	  t[j] = hit[ord[j0+j].i].t;
+	}
+	rtab_passage_v(tab,k->ap,ein,t,m,eut,eerr);
+	for ( int j = 0 ; j < m ; j++ ) {
+	  e[ord[j0+j].i] = eut[j];
+	  err[ord[j0+j].i] = eerr[j];
+	}
+      }
+    }
+    else {
+      for ( int j = lo ; j < hi ; j++ ) {
+	int i = ord[j].i;
+	if ( dir == 0 ) {
+	  e[i] = rtab_passage_d(tab,k->ap,hit[i].ein,hit[i].t,&err[i],&de[i],&dt[i]);
+	}
+	else if ( de == NULL ) {
+	  e[i] = rtab_egassap(tab,k->ap,hit[i].t,hit[i].ein,&err[i])*k->ap;
+	}
+	else {
+	  e[i] = rtab_egassap_d(tab,k->ap,hit[i].t,hit[i].ein,&err[i],&de[i],&dt[i]);
+	}
+      }
+    }
+  }
+  range_leave();
+
+  free(ord);
+}
+
+/*
+  Calculate the energy after passage for n hits with mixed projectiles
+  and absorbers, stored in eut[] and err[] in the order of the hits.
+*/
+void passage_batch(const struct range_hit *hit, int n, double *eut, double *err) {
+  batch(hit,n,0,eut,err,NULL,NULL);
+}
+
+/*
+  As passage_batch(), with the derivatives dEout/dEin and dEout/dt.
+*/
+void passage_d_batch(const struct range_hit *hit, int n, double *eut, double *err,
+		     double *dein, double *dt) {
+  batch(hit,n,0,eut,err,dein,dt);
+}
+
+/*
+  Calculate the energy before passage for n hits, where the energy of a
+  hit is the energy after passage, stored in ein[] and err[] in the
+  order of the hits.
+*/
+void egassap_batch(const struct range_hit *hit, int n, double *ein, double *err) {
+  batch(hit,n,1,ein,err,NULL,NULL);
+}
+
+/*
+  As egassap_batch(), with the derivatives dEin/dEout and dEin/dt.
+*/
+void egassap_d_batch(const struct range_hit *hit, int n, double *ein, double *err,
+		     double *deut, double *dt) {
+  batch(hit,n,1,ein,err,deut,dt);
+}
+
+/*
+  Correlation used at energy ea (MeV/A), as passage() (dir 0) or
+  egassap() (dir 1).
+*/
+int rtab_icorr(int icorr, double ea, int dir) {
+  if ( icorr == 0 && ea > 12.0 ) return 1;
+  if ( dir == 0 && icorr == 1 && ea <= 2.5 ) return 0;
+  return icorr;
+}
+
+// The vector functions index their tables by correlation
+static void check_icorr(int icorr) {
+  if ( icorr < 0 || icorr > 2 ) {
+    fprintf(stderr,"No valid range correlation.\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+/*
+  Calculate the energy after passage of n ions of one projectile and
+  absorber, with energies ein[i] and thicknesses t[i]. The results are
+  those of passage().
+*/
+void passage_v(int icorr, int zp, int ap, int iabso, int zt, int at,
+	       int n, const double *ein, const double *t, double *eut, double *err) {
+
+  const struct rtab *tab[3] = {NULL,NULL,NULL};
+  double e[NBLK], x[NBLK], eu[NBLK], ee[NBLK];
+  int idx[NBLK];
+
+  check_icorr(icorr);
+  range_enter();
+  for ( int i0 = 0 ; i0 < n ; i0 += NBLK ) {
+    int m = n - i0 < NBLK ? n - i0 : NBLK;
+    // the block is calculated once for each correlation it uses
+    for ( int c = 0 ; c < 3 ; c++ ) {
+      int k = 0;
+      for ( int i = i0 ; i < i0 + m ; i++ ) {
+	if ( rtab_icorr(icorr,ein[i]/ap,0) != c ) continue;
+	idx[k] = i;
+	e[k] = ein[i];
+	x[k++] = t[i];
+      }
+      if ( k == 0 ) continue;
+      if ( tab[c] == NULL ) tab[c] = rtab_get(c,zp,ap,iabso,zt,at);
+      rtab_passage_v(tab[c],ap,e,x,k,eu,ee);
+      for ( int j = 0 ; j < k ; j++ ) {
+	eut[idx[j]] = eu[j];
+	if ( err != NULL ) err[idx[j]] = ee[j];
+      }
+    }
+  }
+  range_leave();
+}
+
+/*
+  Calculate the energy before passage of n ions with energies eut[i]
+  after thicknesses t[i], as egassap() without its warnings.
+*/
+void egassap_v(int icorr, int zp, int ap, int iabso, int zt, int at,
+	       int n, const double *t, const double *eut, double *ein, double *err) {
+
+  const struct rtab *tab[3] = {NULL,NULL,NULL};
+  double lerr;
+
+  check_icorr(icorr);
+  range_enter();
+  for ( int i = 0 ; i < n ; i++ ) {
+    int c = eut[i]/ap != 0.0 ? rtab_icorr(icorr,eut[i]/ap,1) : icorr;
+    if ( tab[c] == NULL ) tab[c] = rtab_get(c,zp,ap,iabso,zt,at);
+    ein[i] = rtab_egassap(tab[c],ap,t[i],eut[i],&lerr)*ap;
+    if ( err != NULL ) err[i] = lerr;
+  }
+  range_leave();
+}
+
+/*
+  Calculate the range of n ions with energies ein[i], as rangen().
+*/
+void rangen_v(int icorr, int zp, int ap, int iabso, int zt, int at,
+	      int n, const double *ein, double *rng) {
+
+  const struct rtab *tab[3] = {NULL,NULL,NULL};
+  double rerr;
+
+  check_icorr(icorr);
+  range_enter();
+  for ( int i = 0 ; i < n ; i++ ) {
+    int c = rtab_icorr(icorr,ein[i]/ap,0);
+    if ( tab[c] == NULL ) tab[c] = rtab_get(c,zp,ap,iabso,zt,at);
+    rng[i] = rtab_range(tab[c],log10(ein[i]/ap),&rerr);
+  }
+  range_leave();
+}
+
+/*
+  Calculate the thicknesses in which n ions of energies ein[i] lose
+  delen[i], as thickn().
+*/
+void thickn_v(int icorr, int zp, int ap, int iabso, int zt, int at,
+	      int n, const double *ein, const double *delen, double *t) {
+
+  const struct rtab *tab[3] = {NULL,NULL,NULL};
+  double rerr, rut;
+
+  check_icorr(icorr);
+  range_enter();
+  for ( int i = 0 ; i < n ; i++ ) {
+    int c = rtab_icorr(icorr,ein[i]/ap,0);
+    if ( tab[c] == NULL ) tab[c] = rtab_get(c,zp,ap,iabso,zt,at);
+    rut = 0.0;
+    if ( ein[i]-delen[i] > 0.0 ) {
+      rut = rtab_range(tab[c],log10((ein[i]-delen[i])/ap),&rerr);
+    }
+    t[i] = rtab_range(tab[c],log10(ein[i]/ap),&rerr) - rut;
+  }
+  range_leave();
+}
+
 /*
   Calculate absorber thickness for a given energy decrement
 */
 double thickn(int icorr, int zp, int ap, int iabso, int zt, int at,
 	      double ein, double delen) {
 
-  double elin, elut, rin, rut, rerr;
-  int n;
+  double t;
+  const struct rtab *tab;
+
+  if ( icorr == 0 && ein/ap > 12.0 ) icorr = 1;  // switch to H-B-G
+  if ( icorr == 1 && ein/ap <= 2.5 ) icorr = 0;  // switch to N-S
+
+  range_enter();
+  tab = rtab_get(icorr,zp,ap,iabso,zt,at);
+  t = rtab_eval(tab,RANGE_THICKN,ein,delen);
+  range_leave();
+
+  if ( atomic_load_explicit(&rtab_shadow_on,memory_order_relaxed) ) {
+    rtab_shadow(RANGE_THICKN,icorr,zp,ap,iabso,zt,at,ein,delen,t);
+  }
+  return t;
+}
+
+/*
+  Calculate the range of a projectile
+*/
+double rangen(int icorr, int zp, int ap, int iabso, int zt, int at,
+	      double ein) {
 
-  int jj, jjj;
+  double rut;
+  const struct rtab *tab;
 
-  double *em = malloc(NMAX*sizeof(double));
-  double *r = malloc(NMAX*sizeof(double));
+  if ( icorr == 0 && ein/ap > 12.0 ) icorr = 1;  // switch to H-B-G
+  if ( icorr == 1 && ein/ap <= 2.5 ) icorr = 0;  // switch to N-S
+
+  range_enter();
+  tab = rtab_get(icorr,zp,ap,iabso,zt,at);
+  rut = rtab_eval(tab,RANGE_RANGEN,ein,0.0);
+  range_leave();
+
+  if ( atomic_load_explicit(&rtab_shadow_on,memory_order_relaxed) ) {
+    rtab_shadow(RANGE_RANGEN,icorr,zp,ap,iabso,zt,at,ein,0.0,rut);
+  }
+  return rut;
+}
+
+/*
+  Energy and stopping power of an ion along its path, from the range
+  table walked once from the range at ein down to 0. With step > 0 the
+  points are at depths 0, step, 2*step, ..., otherwise at depth 0 and
+  at the table points below ein. The last point is at the range, where
+  the energy and the stopping power are 0. depth[] is in mg/cm2, e[] in
+  MeV and dedx[] in MeV/(mg/cm2). Returns the number of points stored,
+  at most nmax.
+*/
+int range_profile(int icorr, int zp, int ap, int iabso, int zt, int at,
+		  double ein, double step, int nmax,
+		  double *depth, double *e, double *dedx) {
+
+  double elin, rin, rres, elg, lerr;
+  const struct rtab *tab;
+  int m = 0, jj;
+
+  if ( nmax <= 0 || ein <= 0.0 ) return 0;
 
   if ( icorr == 0 && ein/ap > 12.0 ) icorr = 1;  // switch to H-B-G
   if ( icorr == 1 && ein/ap <= 2.5 ) icorr = 0;  // switch to N-S
 
-  rangetab(icorr,zp,ap,iabso,zt,at,em,r,&n);
-  jjj = n-3;
+  range_enter();
+  tab = rtab_get(icorr,zp,ap,iabso,zt,at);
+  rtab_complete(tab);
 
   elin = log10(ein/ap);
-  jj = nr_locate(em,n,elin);
-  if ( jj > jjj ) jj = jjj;
-  rin = nr_polint(&em[jj],&r[jj],3,elin,&rerr);
-  if ( ein-delen <= 0.0 ) {
-    rut = 0.0;
+  rin = rtab_range(tab,elin,&lerr);
+  jj = nr_locate(tab->em,tab->n,elin);
+  if ( jj > tab->n-3 ) jj = tab->n-3;
+
+  depth[m] = 0.0;
+  e[m] = ein;
+  dedx[m] = ein * log(10.0) / rtab_slope(tab,jj,elin);
+  m++;
+
+  if ( step > 0.0 ) {
+    for ( int i = 1 ; m < nmax && i * step < rin ; i++ ) {
+      rres = rin - i * step;
+      while ( jj > 0 && tab->r[jj] >= rres ) jj--;
+      elg = nr_polint(&tab->r[jj],&tab->em[jj],3,rres,&lerr);
+      depth[m] = i * step;
+      e[m] = pow(10.0,elg)*ap;
+      dedx[m] = e[m] * log(10.0) / rtab_slope(tab,jj,elg);
+      m++;
+    }
   }
   else {
-    elut = log10((ein-delen)/ap);
-    jj = nr_locate(em,n,elut);
-    if ( jj > jjj ) jj = jjj;
-    rut = nr_polint(&em[jj],&r[jj],3,elut,&rerr);
+    for ( int j = nr_locate(tab->em,tab->n,elin) ; m < nmax && j >= 0 ; j-- ) {
+      if ( tab->em[j] >= elin ) continue;
+      jj = j > tab->n-3 ? tab->n-3 : j;
+      depth[m] = rin - tab->r[j];
+      e[m] = pow(10.0,tab->em[j])*ap;
+      dedx[m] = e[m] * log(10.0) / rtab_slope(tab,jj,tab->em[j]);
+      m++;
+    }
   }
+  range_leave();
 
-  // free allocated memory
-  free(em);
-  free(r);
+  if ( m < nmax ) {
+    depth[m] = rin;
+    e[m] = 0.0;
+    dedx[m] = 0.0;
+    m++;
+  }
 
-  return rin-rut;
+  return m;
 }
 
 /*
-  Calculate the range of a projectile
+  Mean energy (MeV) of an ion of energy ein at the reaction point in a
+  target of thickness t (mg/cm2), for a reaction point uniformly
+  distributed in depth. If the ion is stopped in the target only the
+  path up to its range is used. The RMS width of the energy is stored
+  in rms if not NULL, and if nbin > 0 the fraction of the path with
+  energy in each of nbin bins from emin to emax is stored in hist[].
+
+  The energy is integrated over the residual range with 4 point
+  Gauss-Legendre quadrature between consecutive table points, and the
+  histogram is exact in the range table.
 */
-double rangen(int icorr, int zp, int ap, int iabso, int zt, int at,
-	      double ein) {
-
-  double rut, elin, rerr;
-  int n;
+double range_thick(int icorr, int zp, int ap, int iabso, int zt, int at,
+		   double ein, double t, double *rms, int nbin,
+		   double emin, double emax, double *hist) {
 
-  int jj, jjj;
+  const double xg[4] = {-0.8611363115940526,-0.3399810435848563,
+			0.3399810435848563,0.8611363115940526};
+  const double wg[4] = {0.3478548451374538,0.6521451548625461,
+			0.6521451548625461,0.3478548451374538};
 
-  double *em = malloc(NMAX*sizeof(double));
-  double *r = malloc(NMAX*sizeof(double));
+  double elin, rin, rout, teff, lerr;
+  double s1 = 0.0, s2 = 0.0, mean;
+  const struct rtab *tab;
+  int jj;
 
   if ( icorr == 0 && ein/ap > 12.0 ) icorr = 1;  // switch to H-B-G
   if ( icorr == 1 && ein/ap <= 2.5 ) icorr = 0;  // switch to N-S
 
-  rangetab(icorr,zp,ap,iabso,zt,at,em,r,&n);
-  jjj = n-3;
+  range_enter();
+  tab = rtab_get(icorr,zp,ap,iabso,zt,at);
+  rtab_complete(tab);
 
   elin = log10(ein/ap);
-  jj = nr_locate(em,n,elin);
-  if ( jj > jjj ) jj = jjj;
-  rut = nr_polint(&em[jj],&r[jj],3,elin,&rerr);
+  rin = rtab_range(tab,elin,&lerr);
+  rout = rin - t > 0.0 ? rin - t : 0.0;
+  teff = rin - rout;
+
+  // panels between the table points inside [rout,rin]
+  jj = nr_locate(tab->r,tab->n,rout);
+  for ( double a = rout, b ; a < rin ; a = b ) {
+    while ( jj < tab->n-1 && tab->r[jj+1] <= a ) jj++;
+    b = ( jj < tab->n-1 && tab->r[jj+1] < rin ) ? tab->r[jj+1] : rin;
+    int k = jj > tab->n-3 ? tab->n-3 : jj;
+    for ( int g = 0 ; g < 4 ; g++ ) {
+      double u = 0.5 * (a + b) + 0.5 * (b - a) * xg[g];
+      double e = pow(10.0,nr_polint(&tab->r[k],&tab->em[k],3,u,&lerr))*ap;
+      s1 += 0.5 * (b - a) * wg[g] * e;
+      s2 += 0.5 * (b - a) * wg[g] * e * e;
+    }
+  }
 
-  // free allocated memory
-  free(em);
-  free(r);
+  for ( int k = 0 ; k < nbin ; k++ ) {
+    double e1 = emin + (emax - emin) * k / nbin;
+    double e2 = emin + (emax - emin) * (k + 1) / nbin;
+    double r1 = e1 > 0.0 ? rtab_range(tab,log10(e1/ap),&lerr) : 0.0;
+    double r2 = e2 > 0.0 ? rtab_range(tab,log10(e2/ap),&lerr) : 0.0;
+    if ( r1 < rout ) r1 = rout;
+    if ( r2 > rin ) r2 = rin;
+    hist[k] = ( r2 > r1 && teff > 0.0 ) ? (r2 - r1) / teff : 0.0;
+  }
+  range_leave();
 
-  return rut;
+  if ( teff <= 0.0 ) {
+    if ( rms != NULL ) *rms = 0.0;
+    return ein;
+  }
+  mean = s1 / teff;
+  if ( rms != NULL ) {
+    *rms = s2 / teff - mean * mean > 0.0 ? sqrt(s2 / teff - mean * mean) : 0.0;
+  }
+  return mean;
 }
 
 #ifdef __cplusplus
@@ -0,0 +1,217 @@
+/*
+  Author: Ricardo Yanez
+
+  Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+
+  Task scheduling. The work the library does in parallel, the bulk
+  builds of range_build(), the background builds of range_prefetch()
+  and the threads of the Python module, is handed as tasks to the
+  scheduler registered with range_scheduler(), so that a program with
+  its own thread pool can run it there. If none is registered, the
+  tasks run on a pool of worker threads started on first use.
+
+  License:
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "range.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Largest number of pool threads, and smallest, so that background
+// builds proceed next to a busy caller
+#define NWORKER 64
+#define NWORKER_MIN 2
+
+struct ptask {
+  void (*fn)(void *);
+  void *arg;
+  int done;
+  struct ptask *next;
+};
+
+struct range_task {
+  struct range_sched s;  // scheduler of the task
+  void *h;               // its handle
+};
+
+static pthread_mutex_t slock = PTHREAD_MUTEX_INITIALIZER;
+static struct range_sched sched;
+static int user = 0;
+
+static pthread_mutex_t qlock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t qcond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t qdone = PTHREAD_COND_INITIALIZER;
+static struct ptask *qhead = NULL, *qtail = NULL;
+static pthread_once_t qonce = PTHREAD_ONCE_INIT;
+static int nworker = 0;
+
+static void *worker(void *arg) {
+  struct ptask *t;
+  for (;;) {
+    pthread_mutex_lock(&qlock);
+    while ( qhead == NULL ) {
+      pthread_cond_wait(&qcond,&qlock);
+    }
+    t = qhead;
+    qhead = t->next;
+    if ( qhead == NULL ) qtail = NULL;
+    pthread_mutex_unlock(&qlock);
+
+    t->fn(t->arg);
+
+    pthread_mutex_lock(&qlock);
+    t->done = 1;
+    pthread_cond_broadcast(&qdone);
+    pthread_mutex_unlock(&qlock);
+  }
+  return NULL;
+}
+
+static void start_pool(void) {
+  pthread_t tid;
+  pthread_attr_t attr;
+  int n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+  if ( n < NWORKER_MIN ) n = NWORKER_MIN;
+  if ( n > NWORKER ) n = NWORKER;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr,PTHREAD_CREATE_DETACHED);
+  for ( int i = 0 ; i < n ; i++ ) {
+    if ( pthread_create(&tid,&attr,worker,NULL) == 0 ) nworker++;
+  }
+  pthread_attr_destroy(&attr);
+}
+
+// Built-in scheduler: the pool, or the calling thread if it has no thread
+static void *pool_submit(void *ctx, void (*fn)(void *), void *arg) {
+  struct ptask *t = malloc(sizeof(struct ptask));
+  if ( t == NULL ) {
+    fprintf(stderr,"range: out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  t->fn = fn;
+  t->arg = arg;
+  t->done = 0;
+  t->next = NULL;
+
+  pthread_once(&qonce,start_pool);
+  if ( nworker == 0 ) {
+    fn(arg);
+    t->done = 1;
+    return t;
+  }
+  pthread_mutex_lock(&qlock);
+  if ( qtail == NULL ) {
+    qhead = t;
+  }
+  else {
+    qtail->next = t;
+  }
+  qtail = t;
+  pthread_cond_signal(&qcond);
+  pthread_mutex_unlock(&qlock);
+  return t;
+}
+
+static void pool_wait(void *ctx, void *task) {
+  struct ptask *t = task;
+  pthread_mutex_lock(&qlock);
+  while ( !t->done ) {
+    pthread_cond_wait(&qdone,&qlock);
+  }
+  pthread_mutex_unlock(&qlock);
+  free(t);
+}
+
+/*
+  Register the scheduler s, copied, for the tasks submitted from now
+  on, or go back to the built-in pool if s is NULL. Tasks already
+  submitted are waited for with the scheduler they were submitted to.
+*/
+void range_scheduler(const struct range_sched *s) {
+  if ( s != NULL && (s->submit == NULL || s->wait == NULL) ) {
+    fprintf(stderr,"range_scheduler: submit and wait must be given\n");
+    exit(EXIT_FAILURE);
+  }
+  pthread_mutex_lock(&slock);
+  user = s != NULL;
+  if ( user ) sched = *s;
+  pthread_mutex_unlock(&slock);
+}
+
+/*
+  Run fn(arg) as a task of the current scheduler. The returned handle
+  must be passed to range_join() exactly once. A scheduler whose
+  submit returns NULL has already run fn itself, and there is nothing
+  to wait for.
+*/
+struct range_task *range_submit(void (*fn)(void *), void *arg) {
+
+  struct range_task *t = malloc(sizeof(struct range_task));
+  if ( t == NULL ) {
+    fprintf(stderr,"range_submit: out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  pthread_mutex_lock(&slock);
+  if ( user ) {
+    t->s = sched;
+  }
+  else {
+    t->s.ctx = NULL;
+    t->s.submit = pool_submit;
+    t->s.wait = pool_wait;
+    t->s.nthread = 0;
+  }
+  pthread_mutex_unlock(&slock);
+
+  t->h = t->s.submit(t->s.ctx,fn,arg);
+  return t;
+}
+
+/*
+  Wait for a task to finish and release its handle.
+*/
+void range_join(struct range_task *t) {
+  if ( t == NULL ) return;
+  if ( t->h != NULL ) t->s.wait(t->s.ctx,t->h);
+  free(t);
+}
+
+/*
+  Number of tasks worth running at once: nthread of the registered
+  scheduler, or the number of processors.
+*/
+int range_concurrency(void) {
+  int n = 0;
+  pthread_mutex_lock(&slock);
+  if ( user ) n = sched.nthread;
+  pthread_mutex_unlock(&slock);
+  if ( n <= 0 ) n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? n : 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
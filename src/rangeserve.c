@@ -0,0 +1,327 @@
+/*
+  Author: Ricardo Yanez
+
+  Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+
+  Range calculation server and client over a Unix domain socket.
+
+  A message from the client is a count n (uint32_t) followed by n
+  requests (struct range_req), and the server answers with n results
+  (struct range_res) in the same order. A client may send several
+  messages before reading the answers. Both ends run on the same host,
+  so the structures are sent in host byte order.
+
+  License:
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "rangetab.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+  Clients served at the same time. Each takes a reader slot of the
+  table cache, so this stays well below its limit of threads; more
+  clients wait in the listen queue until one leaves.
+*/
+#define NCLIENT 256
+
+static pthread_mutex_t clients = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cfree = PTHREAD_COND_INITIALIZER;
+static int nclient = 0;
+
+/*
+  Socket path: path if not NULL, else $RANGE_SOCKET, else
+  /tmp/range-<uid>.sock.
+*/
+static void socket_path(const char *path, struct sockaddr_un *addr) {
+  memset(addr,0,sizeof(struct sockaddr_un));
+  addr->sun_family = AF_UNIX;
+  if ( path == NULL ) path = getenv("RANGE_SOCKET");
+  if ( path != NULL ) {
+    strncpy(addr->sun_path,path,sizeof(addr->sun_path)-1);
+  }
+  else {
+    snprintf(addr->sun_path,sizeof(addr->sun_path),"/tmp/range-%d.sock",(int)getuid());
+  }
+}
+
+static int read_full(int fd, void *buf, size_t n) {
+  char *p = buf;
+  while ( n > 0 ) {
+    ssize_t k = read(fd,p,n);
+    if ( k < 0 && errno == EINTR ) continue;
+    if ( k <= 0 ) return -1;
+    p += k;
+    n -= k;
+  }
+  return 0;
+}
+
+static int write_full(int fd, const void *buf, size_t n) {
+  const char *p = buf;
+  while ( n > 0 ) {
+    ssize_t k = send(fd,p,n,MSG_NOSIGNAL);
+    if ( k < 0 && errno == EINTR ) continue;
+    if ( k <= 0 ) return -1;
+    p += k;
+    n -= k;
+  }
+  return 0;
+}
+
+/*
+  A request is valid if the library would not stop on it. User defined
+  compounds (iabso = -1) live in the server process and are refused.
+*/
+static int valid(const struct range_req *q) {
+  if ( q->op < RANGE_PASSAGE || q->op > RANGE_DEDX ) return 0;
+  if ( q->icorr < 0 || q->icorr > 2 ) return 0;
+  if ( q->zp < 1 || q->zp > 118 || q->ap < 1 || q->ap > 290 ) return 0;
+  if ( q->iabso < 0 || (q->iabso > 12 && q->iabso < 100) || q->iabso > 103 ) return 0;
+  if ( q->iabso == 0 && (q->zt < 1 || q->zt > 118 || q->at < 1 || q->at > 290) ) return 0;
+  if ( !isfinite(q->x) || !isfinite(q->y) || q->x < 0.0 || q->y < 0.0 ) return 0;
+  if ( q->op != RANGE_EGASSAP && q->x == 0.0 ) return 0;
+  return 1;
+}
+
+/*
+  Answer n requests. Passages and inverse passages are calculated in
+  batches, grouped by range table.
+*/
+static void answer(const struct range_req *q, int n, struct range_res *s,
+		   struct range_hit *hit, int *idx, double *e, double *err) {
+
+  int m;
+
+  for ( int i = 0 ; i < n ; i++ ) {
+    s[i].value = NAN;
+    s[i].aux = 0.0;
+  }
+
+  for ( int op = RANGE_PASSAGE ; op <= RANGE_EGASSAP ; op++ ) {
+    m = 0;
+    for ( int i = 0 ; i < n ; i++ ) {
+      if ( q[i].op != op || !valid(&q[i]) ) continue;
+      hit[m].key.icorr = q[i].icorr;
+      hit[m].key.zp = q[i].zp;
+      hit[m].key.ap = q[i].ap;
+      hit[m].key.iabso = q[i].iabso;
+      hit[m].key.zt = q[i].zt;
+      hit[m].key.at = q[i].at;
+      // an inverse passage batch takes the energy after the foil
+      hit[m].ein = op == RANGE_PASSAGE ? q[i].x : q[i].y;
+      hit[m].t = op == RANGE_PASSAGE ? q[i].y : q[i].x;
+      idx[m++] = i;
+    }
+    if ( op == RANGE_PASSAGE )
+      passage_batch(hit,m,e,err);
+    else
+      egassap_batch(hit,m,e,err);
+    for ( int k = 0 ; k < m ; k++ ) {
+      s[idx[k]].value = e[k];
+      s[idx[k]].aux = err[k];
+    }
+  }
+
+  for ( int i = 0 ; i < n ; i++ ) {
+    const struct range_req *p = &q[i];
+    if ( !valid(p) ) continue;
+    switch(p->op) {
+    case RANGE_RANGEN:
+      s[i].value = rangen(p->icorr,p->zp,p->ap,p->iabso,p->zt,p->at,p->x);
+      break;
+    case RANGE_THICKN:
+      s[i].value = thickn(p->icorr,p->zp,p->ap,p->iabso,p->zt,p->at,p->x,p->y);
+      break;
+    case RANGE_DEDX: {
+      double se, sn;
+      dedxtab(p->icorr,p->zp,p->ap,p->iabso,p->zt,p->at,p->x/p->ap,&se,&sn);
+      s[i].value = se + sn;
+      s[i].aux = sn;
+      break;
+    }
+    default:
+      break;
+    }
+  }
+}
+
+/*
+  Serve one client until it closes the connection.
+*/
+static void *client(void *arg) {
+
+  int fd = (int)(intptr_t)arg;
+  uint32_t n;
+  int size = 0;
+  struct range_req *q = NULL;
+  struct range_res *s = NULL;
+  struct range_hit *hit = NULL;
+  int *idx = NULL;
+  double *e = NULL, *err = NULL;
+
+  while ( read_full(fd,&n,sizeof(n)) == 0 ) {
+    if ( n > RANGE_MAXREQ ) break;
+    if ( (int)n > size ) {
+      size = n;
+      q = realloc(q,size*sizeof(struct range_req));
+      s = realloc(s,size*sizeof(struct range_res));
+      hit = realloc(hit,size*sizeof(struct range_hit));
+      idx = realloc(idx,size*sizeof(int));
+      e = realloc(e,2*size*sizeof(double));
+      if ( q == NULL || s == NULL || hit == NULL || idx == NULL || e == NULL ) {
+	fprintf(stderr,"range_serve: out of memory\n");
+	exit(EXIT_FAILURE);
+      }
+      err = e + size;
+    }
+    if ( read_full(fd,q,n*sizeof(struct range_req)) != 0 ) break;
+    answer(q,n,s,hit,idx,e,err);
+    if ( write_full(fd,s,n*sizeof(struct range_res)) != 0 ) break;
+  }
+
+  close(fd);
+  free(q);
+  free(s);
+  free(hit);
+  free(idx);
+  free(e);
+
+  pthread_mutex_lock(&clients);
+  nclient--;
+  pthread_cond_signal(&cfree);
+  pthread_mutex_unlock(&clients);
+  return NULL;
+}
+
+/*
+  Listen on the socket path (see socket_path()) and answer requests,
+  one thread per client and at most NCLIENT at a time. Does not return
+  unless the socket cannot be set up, in which case it returns -1.
+*/
+int range_serve(const char *path) {
+
+  struct sockaddr_un addr;
+  struct stat st;
+  pthread_attr_t attr;
+  int fd;
+
+  socket_path(path,&addr);
+  // remove a stale socket, but nothing else
+  if ( stat(addr.sun_path,&st) == 0 && S_ISSOCK(st.st_mode) ) {
+    unlink(addr.sun_path);
+  }
+  if ( (fd = socket(AF_UNIX,SOCK_STREAM,0)) < 0 ||
+       bind(fd,(struct sockaddr *)&addr,sizeof(addr)) != 0 ||
+       listen(fd,64) != 0 ) {
+    fprintf(stderr,"range_serve: %s: %s\n",addr.sun_path,strerror(errno));
+    if ( fd >= 0 ) close(fd);
+    return -1;
+  }
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr,PTHREAD_CREATE_DETACHED);
+  for (;;) {
+    pthread_t tid;
+    int c;
+    pthread_mutex_lock(&clients);
+    while ( nclient >= NCLIENT ) {
+      pthread_cond_wait(&cfree,&clients);
+    }
+    pthread_mutex_unlock(&clients);
+    if ( (c = accept(fd,NULL,NULL)) < 0 ) {
+      if ( errno == EINTR || errno == ECONNABORTED ) continue;
+      fprintf(stderr,"range_serve: %s\n",strerror(errno));
+      break;
+    }
+    pthread_mutex_lock(&clients);
+    nclient++;
+    pthread_mutex_unlock(&clients);
+    if ( pthread_create(&tid,&attr,client,(void *)(intptr_t)c) != 0 ) {
+      pthread_mutex_lock(&clients);
+      nclient--;
+      pthread_mutex_unlock(&clients);
+      close(c);
+    }
+  }
+  pthread_attr_destroy(&attr);
+  close(fd);
+  return -1;
+}
+
+/*
+  Connect to a server. Returns the socket, or -1.
+*/
+int range_connect(const char *path) {
+  struct sockaddr_un addr;
+  int fd;
+  socket_path(path,&addr);
+  if ( (fd = socket(AF_UNIX,SOCK_STREAM,0)) < 0 ) return -1;
+  if ( connect(fd,(struct sockaddr *)&addr,sizeof(addr)) != 0 ) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/*
+  Send a message of n requests. Returns 0, or -1 if the connection is
+  lost or n is larger than RANGE_MAXREQ.
+*/
+int range_send(int fd, const struct range_req *req, int n) {
+  uint32_t m = n;
+  if ( n < 0 || n > RANGE_MAXREQ ) return -1;
+  if ( write_full(fd,&m,sizeof(m)) != 0 ) return -1;
+  return write_full(fd,req,n*sizeof(struct range_req));
+}
+
+/*
+  Receive the n results of a message. Returns 0, or -1 if the
+  connection is lost.
+*/
+int range_recv(int fd, struct range_res *res, int n) {
+  return read_full(fd,res,n*sizeof(struct range_res));
+}
+
+int range_query(int fd, const struct range_req *req, int n, struct range_res *res) {
+  if ( range_send(fd,req,n) != 0 ) return -1;
+  return range_recv(fd,res,n);
+}
+
+void range_disconnect(int fd) {
+  close(fd);
+}
+
+#ifdef __cplusplus
+}
+#endif
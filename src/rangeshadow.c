@@ -0,0 +1,247 @@
+/*
+  Author: Ricardo Yanez
+
+  Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+
+  Shadow validation. When enabled with range_shadow(), a random
+  fraction of the calls of passage(), egassap(), rangen() and thickn()
+  is calculated again from a reference table, complete and built from
+  the stopping powers whatever range_lazy() and range_scaling() are
+  set to and whether it is in the table pack, with the interpolation
+  of the library. The deviations of the
+  results from the reference are counted for each function, and those
+  beyond a tolerance are warned about or abort the program. The
+  reference tables are kept apart from the table cache.
+
+  License:
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "range.h"
+#include "rangetab.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Reference tables kept, and functions checked
+#define NREF 256
+#define NOP 4
+
+static const char *name[NOP] = {"passage","egassap","rangen","thickn"};
+
+atomic_int rtab_shadow_on = 0;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static struct rtab *ref[NREF];
+static int nref = 0;
+
+static _Atomic uint64_t thresh;  // a call is checked if its random word is below
+static double tol;
+static int action;
+
+struct shadow {
+  unsigned long n, nover;
+  double sum, max;
+  struct range_key key;  // of the largest deviation
+  double x, y, v, r;
+};
+static struct shadow sh[NOP];
+
+// Per thread xorshift64* state, seeded from the address of the state
+static _Thread_local uint64_t rng = 0;
+
+static inline uint64_t next(void) {
+  if ( rng == 0 ) rng = (uint64_t)(uintptr_t)&rng | 1;
+  rng ^= rng >> 12;
+  rng ^= rng << 25;
+  rng ^= rng >> 27;
+  return rng * 0x2545F4914F6CDD1Dull;
+}
+
+// A call of function k, as in the source
+static void call(FILE *fp, int k, const struct range_key *key, double x, double y) {
+  fprintf(fp,"%s(%d,%d,%d,%d,%d,%d,%g",name[k],key->icorr,key->zp,key->ap,
+	  key->iabso,key->zt,key->at,x);
+  if ( k != RANGE_RANGEN-RANGE_PASSAGE ) fprintf(fp,",%g",y);
+  fprintf(fp,")");
+}
+
+// The reference table of a key, or NULL. Called with the shadow lock held.
+static const struct rtab *find(int icorr, int zp, int ap, int iabso, int zt, int at) {
+  for ( int i = 0 ; i < nref ; i++ ) {
+    const struct rtab *t = ref[i];
+    if ( t->icorr == icorr && t->zp == zp && t->ap == ap && t->iabso == iabso &&
+	 t->zt == zt && t->at == at ) return t;
+  }
+  return NULL;
+}
+
+/*
+  The reference table of a key, built on first use without the shadow
+  lock, and from the stopping powers even if the key is in the table
+  pack, so that the pack is checked too. Called with the shadow lock
+  held, which it releases while building.
+*/
+static const struct rtab *reference(int icorr, int zp, int ap, int iabso, int zt, int at) {
+
+  const struct rtab *t = find(icorr,zp,ap,iabso,zt,at);
+  struct rtab h, *b;
+
+  if ( t != NULL ) return t;
+  pthread_mutex_unlock(&lock);
+  range_lock();
+  rtab_head(&h,icorr,zp,ap,iabso,zt,at);
+  range_unlock();
+  b = rtab_calc(&h,0);
+  b->priv = 1;
+  pthread_mutex_lock(&lock);
+
+  // another thread may have built it meanwhile
+  if ( (t = find(icorr,zp,ap,iabso,zt,at)) != NULL ) {
+    rtab_free(b);
+    return t;
+  }
+  // full, start again
+  if ( nref == NREF ) {
+    for ( int i = 0 ; i < nref ; i++ ) {
+      rtab_free(ref[i]);
+    }
+    nref = 0;
+  }
+  ref[nref++] = b;
+  return b;
+}
+
+/*
+  Check the result v of a call of op with arguments x and y, on the
+  table of the given key, if the call is sampled.
+*/
+void rtab_shadow(int op, int icorr, int zp, int ap, int iabso, int zt, int at,
+		 double x, double y, double v) {
+
+  struct shadow *st = &sh[op-RANGE_PASSAGE];
+  double r, d;
+
+  if ( next() >= atomic_load_explicit(&thresh,memory_order_relaxed) ) return;
+
+  pthread_mutex_lock(&lock);
+  r = rtab_eval(reference(icorr,zp,ap,iabso,zt,at),op,x,y);
+  // relative to the larger, so a stopped ion on one side only counts 1
+  d = (r != 0.0 || v != 0.0) ? fabs(v - r) / fmax(fabs(r),fabs(v)) : 0.0;
+  if ( isnan(d) ) d = INFINITY;
+  st->n++;
+  st->sum += d;
+  if ( d > st->max || st->n == 1 ) {
+    st->max = d;
+    st->key = (struct range_key){icorr,zp,ap,iabso,zt,at};
+    st->x = x;
+    st->y = y;
+    st->v = v;
+    st->r = r;
+  }
+  if ( d > tol ) {
+    if ( action != RANGE_SHADOW_COUNT && (st->nover == 0 || action == RANGE_SHADOW_ABORT) ) {
+      struct range_key key = {icorr,zp,ap,iabso,zt,at};
+      fprintf(stderr,"range: ");
+      call(stderr,op-RANGE_PASSAGE,&key,x,y);
+      fprintf(stderr," = %.10g, reference %.10g, deviation %.3g above %.3g\n",v,r,d,tol);
+    }
+    if ( action == RANGE_SHADOW_ABORT ) abort();
+    st->nover++;
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+/*
+  Check a fraction frac of the calls of passage(), egassap(), rangen()
+  and thickn() against the reference, clearing the statistics, or stop
+  if frac is 0. A relative deviation above tol is counted, and with
+  action RANGE_SHADOW_WARN the first of each function is printed to
+  stderr, with RANGE_SHADOW_ABORT each aborts the program.
+*/
+void range_shadow(double frac, double dtol, int act) {
+
+  if ( frac < 0.0 || frac > 1.0 || dtol < 0.0 || act < RANGE_SHADOW_COUNT ||
+       act > RANGE_SHADOW_ABORT ) {
+    fprintf(stderr,"range_shadow: invalid arguments\n");
+    exit(EXIT_FAILURE);
+  }
+  pthread_mutex_lock(&lock);
+  if ( frac > 0.0 ) {
+    for ( int k = 0 ; k < NOP ; k++ ) {
+      sh[k] = (struct shadow){0};
+    }
+  }
+  tol = dtol;
+  action = act;
+  atomic_store(&thresh,frac >= 1.0 ? UINT64_MAX : (uint64_t)(frac * 18446744073709551616.0));
+  atomic_store(&rtab_shadow_on,frac > 0.0);
+  pthread_mutex_unlock(&lock);
+}
+
+/*
+  Statistics of op (RANGE_PASSAGE, RANGE_EGASSAP, RANGE_RANGEN or
+  RANGE_THICKN): the number of deviations above the tolerance and the
+  mean and largest deviation. Any of the pointers may be NULL. Returns
+  the number of calls checked.
+*/
+unsigned long range_shadow_get(int op, unsigned long *nover, double *mean, double *max) {
+
+  unsigned long n;
+
+  if ( op < RANGE_PASSAGE || op > RANGE_THICKN ) {
+    fprintf(stderr,"range_shadow_get: invalid function %d\n",op);
+    exit(EXIT_FAILURE);
+  }
+  pthread_mutex_lock(&lock);
+  const struct shadow *st = &sh[op-RANGE_PASSAGE];
+  n = st->n;
+  if ( nover != NULL ) *nover = st->nover;
+  if ( mean != NULL ) *mean = n ? st->sum / n : 0.0;
+  if ( max != NULL ) *max = st->max;
+  pthread_mutex_unlock(&lock);
+  return n;
+}
+
+/*
+  Print the statistics of the functions checked, with the call of the
+  largest deviation.
+*/
+void range_shadow_report(FILE *fp) {
+  pthread_mutex_lock(&lock);
+  for ( int k = 0 ; k < NOP ; k++ ) {
+    const struct shadow *st = &sh[k];
+    if ( st->n == 0 ) continue;
+    fprintf(fp,"%s: %lu calls checked, %lu above %.3g, mean deviation %.3g, largest %.3g\n",
+	    name[k],st->n,st->nover,tol,st->sum / st->n,st->max);
+    fprintf(fp,"  largest at ");
+    call(fp,k,&st->key,st->x,st->y);
+    fprintf(fp," = %.10g, reference %.10g\n",st->v,st->r);
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+#ifdef __cplusplus
+}
+#endif
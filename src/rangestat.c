@@ -0,0 +1,157 @@
+/*
+  Author: Ricardo Yanez
+
+  Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+
+  Interpolation telemetry. When enabled with range_telemetry(), each
+  interpolation in a range table counts the segment it falls in and
+  the decade of its relative error estimate, in counters kept with the
+  table. The counts show which parts of the tables a run uses and how
+  accurate the interpolation is there, to choose grid densities and
+  table representations.
+
+  License:
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "range.h"
+#include "rangetab.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+atomic_int rtab_tel = 0;
+
+/*
+  Count an interpolation at table point jj with relative error rel.
+  Bin k of the error histogram holds 10^-(k+1) <= rel < 10^-k, the
+  first and last bins also the errors above and below.
+*/
+void rtab_note(const struct rtab *t, int jj, double rel) {
+  struct rtab *w = (struct rtab *)t;
+  int k = RANGE_NERR-1;
+  if ( rel > 0.0 ) {
+    double d = floor(-log10(rel));
+    if ( d < k ) k = d < 0.0 ? 0 : (int)d;
+  }
+  atomic_fetch_add_explicit(&w->hits[jj/NSEG],1,memory_order_relaxed);
+  atomic_fetch_add_explicit(&w->herr[k],1,memory_order_relaxed);
+}
+
+static void clear(const struct rtab *t, void *arg) {
+  struct rtab *w = (struct rtab *)t;
+  for ( int k = 0 ; k < t->nseg ; k++ ) {
+    atomic_store_explicit(&w->hits[k],0,memory_order_relaxed);
+  }
+  for ( int k = 0 ; k < RANGE_NERR ; k++ ) {
+    atomic_store_explicit(&w->herr[k],0,memory_order_relaxed);
+  }
+}
+
+/*
+  Start the telemetry, clearing the counters of the cached tables, if
+  on is not 0, or stop it. The counters of a table are lost when it is
+  evicted from the cache.
+*/
+void range_telemetry(int on) {
+  if ( on ) {
+    range_enter();
+    rtab_each(clear,NULL);
+    range_leave();
+  }
+  atomic_store(&rtab_tel,on != 0);
+}
+
+/*
+  Copy the counters of the table of key: the E/A (MeV/A) at the start
+  of each segment and the lookups in it, for at most nmax segments,
+  and the RANGE_NERR bins of the error histogram. Any of the arrays may
+  be NULL. Returns the number of segments, or 0 if the table is not in
+  the cache.
+*/
+int range_telemetry_get(const struct range_key *key, int nmax, double *ea,
+			unsigned long *hits, unsigned long *herr) {
+
+  const struct rtab *t;
+  int nseg = 0;
+
+  range_enter();
+  t = rtab_find(key->icorr,key->zp,key->ap,key->iabso,key->zt,key->at);
+  if ( t != NULL ) {
+    nseg = t->nseg;
+    for ( int k = 0 ; k < nseg && k < nmax ; k++ ) {
+      if ( ea != NULL ) ea[k] = pow(10.0,t->em[k*NSEG]);
+      if ( hits != NULL ) hits[k] = atomic_load_explicit(&t->hits[k],memory_order_relaxed);
+    }
+    for ( int k = 0 ; k < RANGE_NERR && herr != NULL ; k++ ) {
+      herr[k] = atomic_load_explicit(&t->herr[k],memory_order_relaxed);
+    }
+  }
+  range_leave();
+  return nseg;
+}
+
+static void report(const struct rtab *t, void *arg) {
+
+  FILE *fp = arg;
+  unsigned long n = 0, h;
+  int unused = 0;
+
+  for ( int k = 0 ; k < t->nseg ; k++ ) {
+    n += atomic_load_explicit(&t->hits[k],memory_order_relaxed);
+  }
+  if ( n == 0 ) return;
+
+  fprintf(fp,"table %d %d %d %d %d %d: %lu lookups\n",
+	  t->icorr,t->zp,t->ap,t->iabso,t->zt,t->at,n);
+  fprintf(fp,"  E/A (MeV/A)              lookups\n");
+  for ( int k = 0 ; k < t->nseg ; k++ ) {
+    int j1 = (k == t->nseg-1) ? t->n-1 : (k+1)*NSEG;
+    h = atomic_load_explicit(&t->hits[k],memory_order_relaxed);
+    if ( h == 0 ) {
+      unused++;
+      continue;
+    }
+    fprintf(fp,"  %10.4g - %10.4g %10lu\n",
+	    pow(10.0,t->em[k*NSEG]),pow(10.0,t->em[j1]),h);
+  }
+  fprintf(fp,"  %d of %d segments not used\n",unused,t->nseg);
+  fprintf(fp,"  relative error           lookups\n");
+  for ( int k = 0 ; k < RANGE_NERR ; k++ ) {
+    h = atomic_load_explicit(&t->herr[k],memory_order_relaxed);
+    if ( h == 0 ) continue;
+    fprintf(fp,"  %10.0e - %10.0e %10lu\n",pow(10.0,-k-1),pow(10.0,-k),h);
+  }
+}
+
+/*
+  Print the counters of the cached tables that have been used.
+*/
+void range_telemetry_report(FILE *fp) {
+  range_enter();
+  rtab_each(report,fp);
+  range_leave();
+}
+
+#ifdef __cplusplus
+}
+#endif
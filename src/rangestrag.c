@@ -0,0 +1,294 @@
+/*
+  Author: Ricardo Yanez
+
+  Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+
+  Energy straggling. The width of the energy after a layer is that of
+  Bohr, with the effective charge of the ion taken from the ratio of
+  its electronic stopping power to that of a proton at the same
+  velocity, and it is carried to the exit of the layer with the ratio
+  of the stopping powers there and at each depth. The Vavilov model
+  adds the third cumulant of the energy loss distribution, and samples
+  a gamma distribution with its three cumulants, which keeps the tail
+  to large losses of thin layers and becomes Bohr's gaussian for thick
+  ones.
+
+  The samples are drawn from Philox4x32-10 random numbers with the
+  index of the sample as counter, so a sample depends only on the seed
+  and its index, and not on how a run is split into calls or threads.
+
+  License:
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "range.h"
+#include "rangetab.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NBLK 64
+
+// Simpson intervals across a layer
+#define NSTEP 4
+
+// K/A = 4 pi N_A r_e^2 m_e c^2 (MeV cm2/g), m_e c^2 and u (MeV)
+#define KBETHE 0.307075
+#define ME 0.51099895
+#define AMU 931.49410
+
+/*
+  Stopping power (MeV/(mg/cm2)) s and squared effective charge z2 of
+  the ion at m energies ea (MeV/A), with the correlation passage()
+  would use at each.
+*/
+static void stop(int icorr, int zp, int ap, int iabso, int zt, int at,
+		 int m, const double *ea, double *s, double *z2) {
+
+  double e[NBLK], se[NBLK], sn[NBLK], sp[NBLK], spn[NBLK];
+  int idx[NBLK];
+
+  for ( int c = 0 ; c < 3 ; c++ ) {
+    int k = 0;
+    for ( int j = 0 ; j < m ; j++ ) {
+      if ( rtab_icorr(icorr,ea[j],0) != c ) continue;
+      idx[k] = j;
+      e[k++] = ea[j];
+    }
+    if ( k == 0 ) continue;
+    dedxtab_v(c,zp,ap,iabso,zt,at,k,e,se,sn);
+    dedxtab_v(c,1,1,iabso,zt,at,k,e,sp,spn);
+    for ( int j = 0 ; j < k ; j++ ) {
+      s[idx[j]] = se[j] + sn[j];
+      z2[idx[j]] = sp[j] > 0.0 ? se[j] / sp[j] : zp*zp;
+    }
+  }
+}
+
+/*
+  Mean energy eu, variance var and third cumulant k3 of the energy
+  after the layer of m ions. The cumulants are integrated over the
+  layer with Simpson's rule on the mean energies at NSTEP+1 depths.
+  Ions stopped in the layer have all three 0.
+*/
+static void moments(int icorr, int zp, int ap, int iabso, int zt, int at,
+		    double za, int m, const double *ein, const double *t,
+		    double *eu, double *var, double *k3) {
+
+  double e[NSTEP+1][NBLK], x[NBLK], ea[NBLK], s[NBLK], z2[NBLK], sk[NBLK];
+  double sv[NBLK], s3[NBLK];
+  const double r = ME / (ap*AMU);
+
+  for ( int j = 0 ; j < m ; j++ ) {
+    e[0][j] = ein[j];
+  }
+  for ( int k = 1 ; k <= NSTEP ; k++ ) {
+    for ( int j = 0 ; j < m ; j++ ) {
+      x[j] = t[j] * k / NSTEP;
+    }
+    passage_v(icorr,zp,ap,iabso,zt,at,m,ein,x,e[k],NULL);
+  }
+
+  for ( int j = 0 ; j < m ; j++ ) {
+    sv[j] = s3[j] = 0.0;
+  }
+  for ( int k = 0 ; k <= NSTEP ; k++ ) {
+    double w = (k == 0 || k == NSTEP) ? 1.0 : (k % 2 ? 4.0 : 2.0);
+    for ( int j = 0 ; j < m ; j++ ) {
+      // stopped ions are dropped below
+      ea[j] = e[NSTEP][j] > 0.0 ? e[k][j] / ap : 1.0;
+    }
+    stop(icorr,zp,ap,iabso,zt,at,m,ea,s,z2);
+    if ( k == NSTEP ) {
+      for ( int j = 0 ; j < m ; j++ ) {
+	sk[j] = s[j];
+      }
+    }
+    for ( int j = 0 ; j < m ; j++ ) {
+      double g = 1.0 + ea[j] / AMU, b2 = 1.0 - 1.0 / (g*g);
+      double wmax = 2.0 * ME * b2 * g * g / (1.0 + 2.0 * g * r + r * r);
+      double xi = 0.5e-3 * KBETHE * za * z2[j] / b2;  // MeV/(mg/cm2)
+      sv[j] += w * xi * wmax * (1.0 - 0.5 * b2) / (s[j] * s[j]);
+      s3[j] += w * xi * wmax * wmax * (0.5 - b2 / 3.0) / (s[j] * s[j] * s[j]);
+    }
+  }
+
+  for ( int j = 0 ; j < m ; j++ ) {
+    double h = t[j] / NSTEP / 3.0;
+    eu[j] = e[NSTEP][j];
+    if ( eu[j] > 0.0 ) {
+      var[j] = sk[j] * sk[j] * sv[j] * h;
+      k3[j] = sk[j] * sk[j] * sk[j] * s3[j] * h;
+    }
+    else {
+      var[j] = k3[j] = 0.0;
+    }
+  }
+}
+
+// Mass weighted Z/A of the absorber
+static double zovera(int icorr, int zp, int ap, int iabso, int zt, int at) {
+  const struct rtab *tab;
+  double za = 0.0, tw = 0.0;
+  range_enter();
+  tab = rtab_get(icorr,zp,ap,iabso,zt,at);
+  for ( int i = 0 ; i < tab->numel ; i++ ) {
+    za += tab->cmp[i].w * tab->cmp[i].z / tab->cmp[i].a;
+    tw += tab->cmp[i].w;
+  }
+  range_leave();
+  return za / tw;
+}
+
+/*
+  Calculate the mean energy eut[i] and its RMS width sigma[i] (MeV)
+  after passage of n ions of energies ein[i] through thicknesses t[i]
+  (mg/cm2). The mean is that of passage_v(). sigma may be NULL.
+*/
+void range_straggling_v(int icorr, int zp, int ap, int iabso, int zt, int at,
+			int n, const double *ein, const double *t, double *eut,
+			double *sigma) {
+
+  double var[NBLK], k3[NBLK];
+  double za = zovera(icorr == 2 ? 2 : 0,zp,ap,iabso,zt,at);
+
+  for ( int i0 = 0 ; i0 < n ; i0 += NBLK ) {
+    int m = n - i0 < NBLK ? n - i0 : NBLK;
+    moments(icorr,zp,ap,iabso,zt,at,za,m,&ein[i0],&t[i0],&eut[i0],var,k3);
+    for ( int j = 0 ; j < m && sigma != NULL ; j++ ) {
+      sigma[i0+j] = sqrt(var[j]);
+    }
+  }
+}
+
+/*
+  Philox4x32-10 (Salmon et al., SC11): four random words from the
+  counter c and the key k.
+*/
+static inline void philox(uint32_t c[4], uint32_t k0, uint32_t k1) {
+  for ( int r = 0 ; r < 10 ; r++ ) {
+    uint64_t p0 = (uint64_t)0xD2511F53u * c[0];
+    uint64_t p1 = (uint64_t)0xCD9E8D57u * c[2];
+    uint32_t c1 = c[1], c3 = c[3];
+    c[0] = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+    c[1] = (uint32_t)p1;
+    c[2] = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+    c[3] = (uint32_t)p0;
+    k0 += 0x9E3779B9u;
+    k1 += 0xBB67AE85u;
+  }
+}
+
+// Random words of round r of stream s of sample i
+static inline void draw(uint64_t seed, uint64_t i, uint32_t r, uint32_t s, uint32_t w[4]) {
+  w[0] = (uint32_t)i;
+  w[1] = (uint32_t)(i >> 32);
+  w[2] = r;
+  w[3] = s;
+  philox(w,(uint32_t)seed,(uint32_t)(seed >> 32));
+}
+
+// Uniform in (0,1)
+static inline double uniform(uint32_t w) {
+  return (w + 0.5) * (1.0 / 4294967296.0);
+}
+
+// Standard normal (Box-Muller)
+static inline double normal(uint32_t w0, uint32_t w1) {
+  return sqrt(-2.0 * log(uniform(w0))) * cos(2.0 * M_PI * uniform(w1));
+}
+
+/*
+  Gamma variate of shape a and unit scale (Marsaglia and Tsang, ACM
+  TOMS 26 (2000) 363), with the shape raised by one and the result
+  scaled back for a < 1.
+*/
+static double gamma_rand(uint64_t seed, uint64_t i, double a) {
+  double b = a < 1.0 ? a + 1.0 : a, scale = 1.0;
+  double d = b - 1.0 / 3.0, c = 1.0 / sqrt(9.0 * d);
+  uint32_t w[4];
+
+  if ( a < 1.0 ) {
+    draw(seed,i,0,1,w);
+    scale = pow(uniform(w[0]),1.0 / a);
+  }
+  for ( uint32_t r = 0 ; ; r++ ) {
+    draw(seed,i,r,0,w);
+    double x = normal(w[0],w[1]), v = 1.0 + c * x;
+    if ( v <= 0.0 ) continue;
+    v = v * v * v;
+    if ( log(uniform(w[2])) < 0.5 * x * x + d - d * v + d * log(v) ) {
+      return d * v * scale;
+    }
+  }
+}
+
+/*
+  Sample the energy after passage of n ions of energies ein[i] through
+  thicknesses t[i] (mg/cm2), with the straggling of model RANGE_BOHR
+  or RANGE_VAVILOV. Sample i is drawn with counter first+i and key
+  seed, so a run gives the same samples however it is split, provided
+  each call is given the index of its first sample. The samples lie
+  between 0 and ein[i]; ions stopped in the layer give 0.
+*/
+void range_sample_v(int icorr, int zp, int ap, int iabso, int zt, int at,
+		    int model, uint64_t seed, uint64_t first, int n,
+		    const double *ein, const double *t, double *eut) {
+
+  double eu[NBLK], var[NBLK], k3[NBLK];
+  double za;
+
+  if ( model != RANGE_BOHR && model != RANGE_VAVILOV ) {
+    fprintf(stderr,"range_sample_v: invalid straggling model %d\n",model);
+    exit(EXIT_FAILURE);
+  }
+  za = zovera(icorr == 2 ? 2 : 0,zp,ap,iabso,zt,at);
+
+  for ( int i0 = 0 ; i0 < n ; i0 += NBLK ) {
+    int m = n - i0 < NBLK ? n - i0 : NBLK;
+    moments(icorr,zp,ap,iabso,zt,at,za,m,&ein[i0],&t[i0],eu,var,k3);
+    if ( model == RANGE_BOHR ) {
+      for ( int j = 0 ; j < m ; j++ ) {
+	uint32_t w[4];
+	draw(seed,first+i0+j,0,0,w);
+	eu[j] += sqrt(var[j]) * normal(w[0],w[1]);
+      }
+    }
+    else {
+      for ( int j = 0 ; j < m ; j++ ) {
+	if ( var[j] <= 0.0 || k3[j] <= 0.0 ) continue;
+	// the loss is theta*(G - a), G of shape a, less energy for more loss
+	double theta = 0.5 * k3[j] / var[j], a = var[j] / (theta*theta);
+	eu[j] -= theta * (gamma_rand(seed,first+i0+j,a) - a);
+      }
+    }
+    for ( int j = 0 ; j < m ; j++ ) {
+      double e = eu[j] < 0.0 ? 0.0 : eu[j];
+      eut[i0+j] = e > ein[i0+j] ? ein[i0+j] : e;
+    }
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
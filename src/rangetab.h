@@ -0,0 +1,206 @@
+/*
+  Author: Ricardo Yanez
+
+  Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+
+  Range tables and the table cache shared by the rangelib sources.
+
+  License:
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+
+*/
+
+#ifndef _RANGETAB
+#define _RANGETAB
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "range.h"
+
+#ifndef _NMAX
+#define _NMAX
+# define NMAX 4000
+#endif
+
+// Number of points in a table segment
+#define NSEG 64
+
+// Largest projectile and absorber charge
+#define ZMAX 118
+
+/*
+  Stopping power data of an absorber element, independent of the
+  projectile: the points of the aluminium data pool in log10(E/A), the
+  conversion from aluminium at those points, the -log(s(2,a)) function
+  of Hubert et al. at the charge of the element as a spline in
+  log(E/A), and the H-B-G coefficients.
+*/
+struct rside {
+  int zt;
+  double elog[42], ftarg[42];
+  double s2[38], s2y2[38];
+  double b, c, d, x2, x3, x4;
+};
+
+/*
+  Stopping power data of a projectile, independent of the absorber:
+  log10((-dE/dx)/Z2) in aluminium at the points of the data pool.
+*/
+struct rproj {
+  int zp;
+  double dedxz2[42];
+};
+
+/*
+  The stopping power data of one projectile in one absorber element.
+  The functions using them keep no state, so tables may be calculated
+  from several threads.
+*/
+struct pair {
+  int zp, ap, zt, at;
+  const struct rside *s;
+  double dedxz2[42];  // log10((-dE/dx)/Z2) at the points s->elog
+  double ak, a;       // linear extrapolation below the data pool
+  double x1, zx4;     // H-B-G
+  const double *gf, *gh, *gp;  // target factor, s(2,a) and aluminium data
+                               // on the energy grid (tables only)
+};
+
+/*
+  A range table for one projectile and absorber. The table is divided
+  in segments of NSEG points. A lazy table is published with only the
+  range at the first point of each segment, and a segment is built the
+  first time a lookup needs it. A segment is never modified once it is
+  built, so readers need no lock.
+*/
+struct rtab {
+  int icorr, zp, ap, iabso, zt, at;  // key
+  uint64_t seq;                      // build sequence number
+  int numel;                         // absorber composition
+  struct elem cmp[NELMAX];
+  struct pair pair[NELMAX];          // stopping power data
+  int n;                             // number of points
+  double *em;                        // log10(E/A)
+  double *r;                         // range (mg/cm2)
+  int nseg;                          // number of segments
+  double *roff;                      // range at first point of segment
+  double *se;                        // electronic dE/dx (ap = 0 tables)
+  atomic_int *built;                 // segment is built
+  atomic_int complete;               // all segments are built
+  atomic_ulong *hits;                // lookups per segment (telemetry)
+  atomic_ulong herr[RANGE_NERR];     // interpolation error histogram
+  atomic_int ref;                    // open handles (range_table_open())
+  int priv;                          // not in the cache
+};
+
+/*
+  A table of the table pack: its key and the range at the first point
+  of each of its nseg segments, taken from the complete table built by
+  rtab_make().
+*/
+struct rpack {
+  int icorr, zp, ap, iabso, zt, at;
+  int nseg;
+  const double *roff;
+};
+
+/* rangelib.c */
+const struct rside *rside_get(int zt);
+const struct rproj *rproj_get(int zp);
+void rtab_head(struct rtab *h, int icorr, int zp, int ap, int iabso, int zt, int at);
+void rtab_head_cmp(struct rtab *h, int icorr, int zp, int ap,
+		  const struct elem *cmp, int n);
+struct rtab *rtab_make(const struct rtab *h, int lz);
+struct rtab *rtab_calc(const struct rtab *h, int lz);
+struct rtab *rtab_build(int icorr, int zp, int ap, int iabso, int zt, int at);
+struct rtab *rtab_load(const struct rtab *h, const double *roff, int nseg);
+struct rtab *rtab_make_el(const struct rtab *h);
+struct rtab *rtab_scale(const struct rtab *h, const struct rtab *el, int nucl);
+int rtab_lazy(void);
+int rtab_scaling(void);
+void rtab_segment(struct rtab *t, int k);
+void rtab_free(struct rtab *t);
+void dedxtab(int icorr, int zp, int ap, int iabso, int zt, int at,
+	     double e, double *tdedxe, double *tdedxn);
+
+/* rangemath.c */
+void vexp10(const double *x, double *y, int n);
+void vexp(const double *x, double *y, int n);
+void vlog10(const double *x, double *y, int n);
+double sexp10(double x);
+double sexp(double x);
+double slog10(double x);
+
+/* rangecache.c */
+void range_lock(void);
+void range_unlock(void);
+void range_enter(void);
+void range_leave(void);
+const struct rtab *rtab_get(int icorr, int zp, int ap, int iabso, int zt, int at);
+const struct rtab *rtab_put(struct rtab *t);
+const struct rtab *rtab_find(int icorr, int zp, int ap, int iabso, int zt, int at);
+void rtab_need(const struct rtab *t, int k);
+void rtab_complete(const struct rtab *t);
+void rtab_each(void (*f)(const struct rtab *, void *), void *arg);
+
+/*
+  rangetrace.c. TRACE_BEGIN(v) starts a span in v and
+  TRACE_END(v,name,fmt,...) ends it, with fmt and its arguments the
+  members of the event args ("" for none). Without RANGE_TRACE the
+  spans compile to nothing.
+*/
+#ifdef RANGE_TRACE
+uint64_t rtrace_begin(void);
+void rtrace_end(const char *name, uint64_t t0, const char *fmt, ...);
+# define TRACE_BEGIN(v) uint64_t v = rtrace_begin()
+# define TRACE_END(v,name,...) rtrace_end(name,v,__VA_ARGS__)
+#else
+# define TRACE_BEGIN(v)
+# define TRACE_END(v,name,...)
+#endif
+
+/*
+  rangepack.c. The data are generated at build time by rangepackgen.c,
+  sorted by key.
+*/
+extern const struct rpack rtab_pack[];
+extern const int rtab_npack;
+extern const struct rside rtab_pack_sides[];
+extern const int rtab_npack_sides;
+extern const struct rproj rtab_pack_projs[];
+extern const int rtab_npack_projs;
+const struct rpack *rtab_pack_find(int icorr, int zp, int ap, int iabso, int zt, int at);
+const struct rside *rtab_pack_side(int zt);
+const struct rproj *rtab_pack_proj(int zp);
+
+/* rangestat.c */
+extern atomic_int rtab_tel;
+void rtab_note(const struct rtab *t, int jj, double rel);
+
+/* ranges.c */
+double rtab_range(const struct rtab *t, double elg, double *err);
+double rtab_energy(const struct rtab *t, double rng, double *err);
+double rtab_egassap(const struct rtab *tab, int ap, double t, double eut, double *err);
+int rtab_icorr(int icorr, double ea, int dir);
+double rtab_eval(const struct rtab *t, int op, double x, double y);
+
+/* rangeshadow.c */
+extern atomic_int rtab_shadow_on;
+void rtab_shadow(int op, int icorr, int zp, int ap, int iabso, int zt, int at,
+		 double x, double y, double v);
+
+#endif
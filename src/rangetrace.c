@@ -0,0 +1,120 @@
+/*
+  Author: Ricardo Yanez
+
+  Copyright (c) 2026 Ricardo Yanez <ricardo.yanez@calel.org>
+
+  Trace spans of the table builds, compiled in with the CMake option
+  RANGE_TRACE. If the environment variable RANGE_TRACE names a file
+  when the first span ends, every span is written to it as a complete
+  event of the Chrome trace event format, with the process and thread
+  IDs, which chrome://tracing and the Perfetto UI load directly.
+
+  License:
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rangetab.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static FILE *fp = NULL;
+static atomic_int on = 0;
+static long nevent = 0;
+static int pid;
+
+// Small thread numbers, in order of first span
+static atomic_int ntid = 0;
+static _Thread_local int tid = 0;
+
+static void close_trace(void) {
+  pthread_mutex_lock(&lock);
+  if ( fp != NULL ) {
+    atomic_store(&on,0);
+    fprintf(fp,"\n]\n");
+    fclose(fp);
+    fp = NULL;
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+static void open_trace(void) {
+  const char *path = getenv("RANGE_TRACE");
+  if ( path == NULL || *path == '\0' ) return;
+  fp = fopen(path,"w");
+  if ( fp == NULL ) {
+    fprintf(stderr,"range: cannot open trace file %s\n",path);
+    return;
+  }
+  pid = (int)getpid();
+  fprintf(fp,"[\n");
+  atomic_store(&on,1);
+  atexit(close_trace);
+}
+
+/*
+  Start of a span: the time in ns.
+*/
+uint64_t rtrace_begin(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/*
+  End of a span named name that started at t0. The arguments after fmt
+  are printed with it as the members of the args object of the event.
+*/
+void rtrace_end(const char *name, uint64_t t0, const char *fmt, ...) {
+
+  uint64_t t1 = rtrace_begin();
+  va_list ap;
+
+  pthread_once(&once,open_trace);
+  if ( !atomic_load(&on) ) return;
+  if ( tid == 0 ) tid = atomic_fetch_add(&ntid,1) + 1;
+
+  pthread_mutex_lock(&lock);
+  if ( fp != NULL ) {
+    fprintf(fp,"%s{\"name\":\"%s\",\"cat\":\"range\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+	    "\"ts\":%.3f,\"dur\":%.3f,\"args\":{",nevent++ ? ",\n" : "",name,pid,tid,
+	    t0 * 1.0e-3,(t1 - t0) * 1.0e-3);
+    va_start(ap,fmt);
+    vfprintf(fp,fmt,ap);
+    va_end(ap);
+    fprintf(fp,"}}");
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+#ifdef __cplusplus
+}
+#endif